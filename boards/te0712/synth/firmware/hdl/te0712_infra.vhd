@@ -12,9 +12,14 @@ use work.ipbus.all;
 entity te0712_infra is
     generic(
         USE_NEO430 : boolean := False; -- Set to "true" in order to include NEO430
-        NEO430_CLOCK_SPEED : natural := 31250000 ; -- soft core clock speed
+        NEO430_CLOCK_SPEED : natural := 31250000 ; -- soft core clock speed, when clocked from clk_ipb
+        NEO430_CLK125 : boolean := False; -- clk125 instead of clk_ipb for the soft core. Refused until the software derives its I2C prescale
         FORCE_RARP : boolean := False; -- Set True in order to force use of RARP, regardless of PROM
-        UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"50" -- Address on I2C bus of E24AA025E 
+        UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"50"; -- Address on I2C bus of E24AA025E 
+        LATENCY_HIST : boolean := False; -- Set True to build in the IPBus packet latency histogram ( one block RAM, not yet simulated )
+        LATENCY_ADDR : std_logic_vector(31 downto 0) := x"80000800"; -- IPBus address of the latency histogram ( see te0712_infra.xml ), 2k words, taken out of the payload space if LATENCY_HIST
+        I2C_TRACE : boolean := False; -- Set True to build in the trace of the I2C bus ( one block RAM, not yet simulated )
+        I2C_TRACE_ADDR : std_logic_vector(31 downto 0) := x"80000400" -- IPBus address of the I2C trace ( see te0712_infra.xml ), 1k words, likewise if I2C_TRACE
     );
     port(
         eth_clk_p     : in std_logic; -- 125MHz MGT clock
@@ -56,7 +61,8 @@ architecture rtl of te0712_infra is
     COMPONENT ipbus_neo430_wrapper IS
     GENERIC( 
         CLOCK_SPEED : natural := 31250000;
-        UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"50" -- Address on I2C bus of E24AA025E
+        UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"50"; -- Address on I2C bus of E24AA025E
+        CDC_OUTPUTS : boolean := false
         );
     PORT( 
         clk_i      : IN     std_logic;                      -- global clock, rising edge
@@ -72,10 +78,21 @@ architecture rtl of te0712_infra is
         use_rarp_o : OUT    std_logic;                      -- If high then IPBus should use RARP, not fixed IP
         ip_addr_o  : OUT    std_logic_vector(31 downto 0);  -- IP address to give to IPBus core
         mac_addr_o : OUT    std_logic_vector(47 downto 0);  -- MAC address to give to IPBus core
-        ipbus_rst_o: OUT    std_logic                       -- Reset line to IPBus core
+        ipbus_rst_o: OUT    std_logic;                      -- Reset line to IPBus core
+        mac_clk_i  : IN     std_logic := '0';               -- clock of the address outputs, if CDC_OUTPUTS
+        ipb_clk    : IN     std_logic := '0'                -- clock of ipbus_rst_o, if CDC_OUTPUTS
         );
     end component;
-    
+
+    function neo430_clock_speed return natural is
+    begin
+        if NEO430_CLK125 then
+            return 125000000;
+        end if;
+        return NEO430_CLOCK_SPEED;
+    end function;
+
+    signal clk_neo430: std_logic; -- soft core clock
     signal clk125_fr, clk125, clk_ipb, clk_ipb_i, locked, clk_locked, eth_locked, rst125, rst_ipb, rst_ipb_ctrl, rst_eth, onehz, pkt: std_logic;
     signal mac_tx_data, mac_rx_data: std_logic_vector(7 downto 0);
     signal mac_tx_valid, mac_tx_last, mac_tx_error, mac_tx_ready, mac_rx_valid, mac_rx_last, mac_rx_error: std_logic;
@@ -85,6 +102,11 @@ architecture rtl of te0712_infra is
     signal neo430_RARP_select , RARP_select : std_logic := '0'; -- set high to use RARP
     signal s_mac_addr, s_neo430_mac_addr: std_logic_vector(47 downto 0); -- MAC address
     signal s_ip_addr , s_neo430_ip_addr:  std_logic_vector(31 downto 0); -- IP address
+    signal ipb_master_out: ipb_wbus;
+    signal ipb_master_in: ipb_rbus;
+    signal ipb_sel: std_logic_vector(1 downto 0);
+    signal ipb_to_slaves: ipb_wbus_array(2 downto 0);
+    signal ipb_from_slaves: ipb_rbus_array(2 downto 0);
     
 --    attribute mark_debug: string;
 --    attribute mark_debug of mac_tx_data: signal is "True";
@@ -141,15 +163,25 @@ begin
 
     leds <= (led_p(0), locked and onehz);
 
--- Soft core to read MAC and IP address
+-- Soft core to read MAC and IP address. Its clock is independent of the IPBus core: the addresses
+-- are handed over to clk125 ( where the MAC side of ipbus_ctrl uses them ) and its reset to clk_ipb
+    clk_neo430 <= clk125 when NEO430_CLK125 else clk_ipb;
+
+    -- The I2C prescale in the application image is fixed for clk_ipb, so at 125MHz the PROM would be
+    -- read four times too fast. Refuse it until an image that uses CLOCK_SPEED for the prescale is built
+    assert not NEO430_CLK125
+        report "te0712_infra: NEO430_CLK125 needs an application image with a clock-derived I2C prescale"
+        severity failure;
+
     gen_softcore: if USE_NEO430 generate
     soft_core_cpu: ipbus_neo430_wrapper
         generic map(
-            CLOCK_SPEED =>  NEO430_CLOCK_SPEED, -- 31.25MHz IPBus clock
-            UID_I2C_ADDR => UID_I2C_ADDR 
+            CLOCK_SPEED =>  neo430_clock_speed,
+            UID_I2C_ADDR => UID_I2C_ADDR,
+            CDC_OUTPUTS => true
         )
         port map(
-            clk_i       => clk_ipb,         -- global clock, rising edge
+            clk_i       => clk_neo430,      -- global clock, rising edge
             rst_i       => '0',             -- CPU reset. Active high. Async
             uart_txd_o  => uart_txd_o,
             uart_rxd_i  => uart_rxd_i,
@@ -162,7 +194,9 @@ begin
             use_rarp_o  => neo430_RARP_select,
             ip_addr_o   => s_neo430_ip_addr,
             mac_addr_o  => s_neo430_mac_addr,
-            ipbus_rst_o => neo430_nuke
+            ipbus_rst_o => neo430_nuke,
+            mac_clk_i   => clk125,
+            ipb_clk     => clk_ipb
         );
     end generate gen_softcore;
     
@@ -218,8 +252,8 @@ begin
             mac_tx_last  => mac_tx_last,
             mac_tx_error => mac_tx_error,
             mac_tx_ready => mac_tx_ready,
-            ipb_out      => ipb_out,
-            ipb_in       => ipb_in,
+            ipb_out      => ipb_master_out,
+            ipb_in       => ipb_master_in,
             RARP_select  => RARP_select,
             mac_addr     => s_mac_addr,
             ip_addr      => s_ip_addr,
@@ -236,5 +270,78 @@ begin
     --s_mac_addr <= mac_addr;
     --s_ip_addr  <= ip_addr;
     --RARP_select <= '0';
+
+-- Latency histogram and I2C trace, taken out of the address space before the payload. Slave 0 = payload,
+-- 1 = latency histogram, 2 = I2C trace. A block left out leaves its addresses to the payload
+    ipb_sel <= "01" when LATENCY_HIST and ipb_master_out.ipb_addr(31 downto 11) = LATENCY_ADDR(31 downto 11) else
+               "10" when I2C_TRACE and ipb_master_out.ipb_addr(31 downto 10) = I2C_TRACE_ADDR(31 downto 10) else
+               "00";
+
+    fabric: entity work.ipbus_fabric_sel
+        generic map(
+            NSLV => 3,
+            SEL_WIDTH => 2
+        )
+        port map(
+            sel => ipb_sel,
+            ipb_in => ipb_master_out,
+            ipb_out => ipb_master_in,
+            ipb_to_slaves => ipb_to_slaves,
+            ipb_from_slaves => ipb_from_slaves
+        );
+
+    ipb_out <= ipb_to_slaves(0);
+    ipb_from_slaves(0) <= ipb_in;
+
+-- Request to response latency of the packets through ipbus_ctrl, taken from its MAC interface
+    gen_latency: if LATENCY_HIST generate
+    latency: entity work.ipbus_latency_hist
+        port map(
+            ipb_clk      => clk_ipb,
+            ipb_rst      => rst_ipb,
+            ipb_in       => ipb_to_slaves(1),
+            ipb_out      => ipb_from_slaves(1),
+            mac_clk      => clk125,
+            rst_macclk   => rst125,
+            mac_addr     => s_mac_addr,
+            mac_rx_data  => mac_rx_data,
+            mac_rx_valid => mac_rx_valid,
+            mac_rx_last  => mac_rx_last,
+            mac_rx_error => mac_rx_error,
+            mac_tx_data  => mac_tx_data,
+            mac_tx_valid => mac_tx_valid,
+            mac_tx_last  => mac_tx_last,
+            mac_tx_error => mac_tx_error,
+            mac_tx_ready => mac_tx_ready
+        );
+    end generate gen_latency;
+
+    gen_no_latency: if LATENCY_HIST = false generate
+        ipb_from_slaves(1) <= IPB_RBUS_NULL;
+    end generate gen_no_latency;
+
+-- Passive trace of the I2C bus of the soft core ( PROM reads at boot ). On the soft core clock and
+-- never reset, since the soft core holds IPBus in reset until the PROM has been read: the trace
+-- starts at power up, and is armed again over IPBus
+    gen_i2c_trace: if I2C_TRACE generate
+    i2c_trace: entity work.ipbus_i2c_trace
+        generic map(
+            CLOCK_SPEED  => neo430_clock_speed
+        )
+        port map(
+            ipb_clk      => clk_ipb,
+            ipb_rst      => rst_ipb,
+            ipb_in       => ipb_to_slaves(2),
+            ipb_out      => ipb_from_slaves(2),
+            clk          => clk_neo430,
+            rst          => '0',
+            scl_i        => fpga_i2c_scl_i,
+            sda_i        => fpga_i2c_sda_i
+        );
+    end generate gen_i2c_trace;
+
+    gen_no_i2c_trace: if I2C_TRACE = false generate
+        ipb_from_slaves(2) <= IPB_RBUS_NULL;
+    end generate gen_no_i2c_trace;
     
 end rtl;
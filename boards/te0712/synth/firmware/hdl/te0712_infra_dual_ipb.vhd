@@ -8,13 +8,18 @@ library ieee;
 use ieee.STD_LOGIC_1164.ALL;
 
 use work.ipbus.all;
+use work.ipbus_reg_types.all;
 
 entity te0712_infra is
     generic(
         USE_NEO430 : boolean := False; -- Set to "true" in order to include NEO430
         NEO430_CLOCK_SPEED : natural := 31250000 ; -- soft core clock speed
         FORCE_RARP : boolean := False; -- Set True in order to force use of RARP, regardless of PROM
-        UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"50" -- Address on I2C bus of E24AA025E 
+        UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"50"; -- Address on I2C bus of E24AA025E 
+        ARB_STATS : boolean := False; -- Set True to make the arbiter counters readable. Takes 8 words out of the payload space
+        ARB_STAT_ADDR : std_logic_vector(31 downto 0) := x"80000000"; -- IPBus address of the arbiter counters ( see te0712_infra_dual_ipb.xml )
+        BP_CONFIG : boolean := False; -- Set True to make the backplane config register readable. Takes 1 word out of the payload space
+        BP_CONFIG_ADDR : std_logic_vector(31 downto 0) := x"80000008" -- IPBus address of the backplane config register ( top_mib_gbe_bp.xml )
     );
     port(
         eth_clk_p     : in std_logic; -- 125MHz MGT clock
@@ -36,7 +41,7 @@ entity te0712_infra is
         leds          : out std_logic_vector(1 downto 0); -- status LEDs
         mac_addr      : in std_logic_vector(47 downto 0) := (others => '0'); -- MAC address
         ip_addr       : in std_logic_vector(31 downto 0) := (others => '0'); -- IP address
-        ipb_in        : in ipb_rbus; -- ipbus
+        ipb_in        : in ipb_rbus; -- ipbus, shared by the front-panel and backplane controllers
         ipb_out       : out ipb_wbus;
         fpga_i2c_scl_i: in std_logic := '0';
         fpga_i2c_sda_i: in std_logic := '0';
@@ -61,7 +66,8 @@ architecture rtl of te0712_infra is
     COMPONENT ipbus_neo430_wrapper IS
     GENERIC( 
         CLOCK_SPEED : natural := 31250000;
-        UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"50" -- Address on I2C bus of E24AA025E
+        UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"50"; -- Address on I2C bus of E24AA025E
+        CDC_OUTPUTS : boolean := false
         );
     PORT( 
         clk_i      : IN     std_logic;                      -- global clock, rising edge
@@ -77,7 +83,9 @@ architecture rtl of te0712_infra is
         use_rarp_o : OUT    std_logic;                      -- If high then IPBus should use RARP, not fixed IP
         ip_addr_o  : OUT    std_logic_vector(31 downto 0);  -- IP address to give to IPBus core
         mac_addr_o : OUT    std_logic_vector(47 downto 0);  -- MAC address to give to IPBus core
-        ipbus_rst_o: OUT    std_logic                       -- Reset line to IPBus core
+        ipbus_rst_o: OUT    std_logic;                      -- Reset line to IPBus core
+        mac_clk_i  : IN     std_logic := '0';               -- clock of the address outputs, if CDC_OUTPUTS
+        ipb_clk    : IN     std_logic := '0'                -- clock of ipbus_rst_o, if CDC_OUTPUTS
         );
     end component;
     
@@ -96,6 +104,19 @@ architecture rtl of te0712_infra is
     signal gt0_pll0outclk_in, gt0_pll0outrefclk_in, gt0_pll1outclk_in, gt0_pll1outrefclk_in, gt0_pll0lock_in, gt0_pll0refclklost_in : std_logic; 
     signal mmcm_locked : std_logic;
     
+    -- Front-panel (0) and backplane (1) ipbus masters, before arbitration
+    signal ipb_m_out: ipb_wbus_array(1 downto 0);
+    signal ipb_m_in: ipb_rbus_array(1 downto 0);
+    signal ipb_req, ipb_grant: std_logic_vector(1 downto 0);
+    
+    -- After arbitration: payload (0), arbiter counters (1) and backplane config (2)
+    signal ipb_arb_out: ipb_wbus;
+    signal ipb_arb_in: ipb_rbus;
+    signal ipb_sel: std_logic_vector(1 downto 0);
+    signal ipb_to_slaves: ipb_wbus_array(2 downto 0);
+    signal ipb_from_slaves: ipb_rbus_array(2 downto 0);
+    signal arb_stat: ipb_reg_v(7 downto 0);
+    
 begin
 
 --	DCM clock generation for internal bus, ethernet
@@ -141,12 +162,14 @@ begin
 
 	leds <= (led_p(0), locked and onehz);
 	
-	-- Soft core to read MAC and IP address
+	-- Soft core to read MAC and IP address. It runs from clk_ipb; the addresses are handed over to
+	-- clk125, where the MAC side of ipbus_ctrl uses them
     gen_softcore: if USE_NEO430 generate
     soft_core_cpu: ipbus_neo430_wrapper
         generic map(
             CLOCK_SPEED =>  NEO430_CLOCK_SPEED, -- 31.25MHz IPBus clock
-            UID_I2C_ADDR => UID_I2C_ADDR 
+            UID_I2C_ADDR => UID_I2C_ADDR,
+            CDC_OUTPUTS => true
         )
         port map(
             clk_i       => clk_ipb,         -- global clock, rising edge
@@ -162,7 +185,9 @@ begin
             use_rarp_o  => neo430_RARP_select,
             ip_addr_o   => s_neo430_ip_addr,
             mac_addr_o  => s_neo430_mac_addr,
-            ipbus_rst_o => neo430_nuke
+            ipbus_rst_o => neo430_nuke,
+            mac_clk_i   => clk125,
+            ipb_clk     => clk_ipb
         );
     end generate gen_softcore;
     
@@ -228,8 +253,10 @@ begin
 			mac_tx_last  => mac_tx_last,
 			mac_tx_error => mac_tx_error,
 			mac_tx_ready => mac_tx_ready,
-		    ipb_out      => ipb_out,
-			ipb_in       => ipb_in,
+			ipb_out      => ipb_m_out(0),
+			ipb_in       => ipb_m_in(0),
+			ipb_req      => ipb_req(0),
+			ipb_grant    => ipb_grant(0),
 			RARP_select  => RARP_select,
 			mac_addr     => s_mac_addr,
 			ip_addr      => s_ip_addr,
@@ -245,6 +272,9 @@ begin
 --------------------------------------------------------------------------------
 --  Backplane GbE + IPBus core.
 bp_eth_ipbus: entity work.mib_bp_ipbus
+    generic map(
+        SHARED_BUS      => True
+    )
     port map(
         ipb_clk         => clk_ipb,
         rst_125         => rst_125_bp,
@@ -267,7 +297,72 @@ bp_eth_ipbus: entity work.mib_bp_ipbus
         user_clk                => user_clk,
         gtrefclk_out            => gtrefclk_out,
         mmcm_locked             => mmcm_locked,
-        bp_eth_locked           => eth_bp_locked
+        bp_eth_locked           => eth_bp_locked,
+        ipb_out                 => ipb_m_out(1),
+        ipb_in                  => ipb_m_in(1),
+        ipb_req                 => ipb_req(1),
+        ipb_grant               => ipb_grant(1),
+        ipb_cfg_in              => ipb_to_slaves(2),
+        ipb_cfg_out             => ipb_from_slaves(2)
     );
 
+--------------------------------------------------------------------------------
+--  Both controllers share the payload fabric, one packet at a time.
+    arb: entity work.ipbus_arb_rr
+        generic map(
+            N_BUS => 2
+        )
+        port map(
+            clk         => clk_ipb,
+            rst         => rst_ipb,
+            ipb_m_out   => ipb_m_out,
+            ipb_m_in    => ipb_m_in,
+            ipb_req     => ipb_req,
+            ipb_grant   => ipb_grant,
+            ipb_out     => ipb_arb_out,
+            ipb_in      => ipb_arb_in,
+            stat        => arb_stat(5 downto 0)
+        );
+
+-- Arbiter counters and backplane config, taken out of the address space before the payload when enabled.
+-- Slave 0 = payload, 1 = counters, 2 = backplane config
+    ipb_sel <= "01" when ARB_STATS and ipb_arb_out.ipb_addr(31 downto 3) = ARB_STAT_ADDR(31 downto 3) else
+               "10" when BP_CONFIG and ipb_arb_out.ipb_addr = BP_CONFIG_ADDR else
+               "00";
+
+    fabric: entity work.ipbus_fabric_sel
+        generic map(
+            NSLV => 3,
+            SEL_WIDTH => 2
+        )
+        port map(
+            sel => ipb_sel,
+            ipb_in => ipb_arb_out,
+            ipb_out => ipb_arb_in,
+            ipb_to_slaves => ipb_to_slaves,
+            ipb_from_slaves => ipb_from_slaves
+        );
+
+    ipb_out <= ipb_to_slaves(0);
+    ipb_from_slaves(0) <= ipb_in;
+
+    gen_arb_stats: if ARB_STATS generate
+        -- Same clock as the arbiter, so read directly. Words 6 and 7 read zero
+        arb_stat(7 downto 6) <= (others => (others => '0'));
+
+        arb_stat_reg: entity work.ipbus_roreg_v
+            generic map(
+                N_REG => 8
+            )
+            port map(
+                ipb_in => ipb_to_slaves(1),
+                ipb_out => ipb_from_slaves(1),
+                d => arb_stat
+            );
+    end generate gen_arb_stats;
+
+    gen_no_arb_stats: if not ARB_STATS generate
+        ipb_from_slaves(1) <= IPB_RBUS_NULL;
+    end generate gen_no_arb_stats;
+
 end rtl;
@@ -0,0 +1,118 @@
+-- ipbus_arb_rr
+--
+-- Round-robin arbiter between several ipbus masters (e.g. the front-panel and
+-- backplane ipbus_ctrl blocks), driving a single slave fabric.
+--
+-- The bus is granted for a whole packet using the ipb_req / ipb_grant handshake
+-- of ipbus_ctrl. When the owner drops its request, the next requesting master
+-- after it (in round-robin order) is granted, so a busy master cannot starve
+-- the others.
+--
+-- Per-master statistics (free-running, cleared by rst):
+--   stat(3 * i)     : number of grants (packets) given to master i
+--   stat(3 * i + 1) : number of ipbus transactions (ack or err) of master i
+--   stat(3 * i + 2) : number of clock cycles master i spent waiting for a grant
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+use work.ipbus.all;
+use work.ipbus_reg_types.all;
+
+entity ipbus_arb_rr is
+	generic(
+		N_BUS: positive := 2
+	);
+	port(
+		clk: in std_logic;
+		rst: in std_logic;
+		ipb_m_out: in ipb_wbus_array(N_BUS - 1 downto 0); -- from the masters
+		ipb_m_in: out ipb_rbus_array(N_BUS - 1 downto 0);
+		ipb_req: in std_logic_vector(N_BUS - 1 downto 0);
+		ipb_grant: out std_logic_vector(N_BUS - 1 downto 0);
+		ipb_out: out ipb_wbus; -- to the slave fabric
+		ipb_in: in ipb_rbus;
+		stat: out ipb_reg_v(3 * N_BUS - 1 downto 0)
+	);
+
+end ipbus_arb_rr;
+
+architecture rtl of ipbus_arb_rr is
+
+	type ctr_array_t is array(N_BUS - 1 downto 0) of unsigned(31 downto 0);
+
+	signal src: integer range 0 to N_BUS - 1 := 0;
+	signal busy: std_logic := '0';
+	signal grant, grant_d: std_logic_vector(N_BUS - 1 downto 0);
+	signal ctr_grant, ctr_xact, ctr_wait: ctr_array_t;
+
+begin
+
+	process(clk)
+		variable sel: integer range 0 to N_BUS - 1;
+		variable found: boolean;
+	begin
+		if rising_edge(clk) then
+			if rst = '1' then
+				busy <= '0';
+				src <= 0;
+			elsif busy = '0' then
+				-- Search downwards so that the master closest after the last owner wins;
+				-- the last owner itself (i = N_BUS) has the lowest priority.
+				sel := src;
+				found := false;
+				for i in N_BUS downto 1 loop
+					if ipb_req((src + i) mod N_BUS) = '1' then
+						sel := (src + i) mod N_BUS;
+						found := true;
+					end if;
+				end loop;
+				if found then
+					src <= sel;
+					busy <= '1';
+				end if;
+			elsif ipb_req(src) = '0' then
+				busy <= '0';
+			end if;
+		end if;
+	end process;
+
+	ipb_out <= ipb_m_out(src) when busy = '1' else IPB_WBUS_NULL;
+
+	gen_m: for i in N_BUS - 1 downto 0 generate
+
+		grant(i) <= '1' when busy = '1' and src = i else '0';
+		ipb_m_in(i) <= ipb_in when grant(i) = '1' else IPB_RBUS_NULL;
+
+		process(clk)
+		begin
+			if rising_edge(clk) then
+				grant_d(i) <= grant(i);
+				if rst = '1' then
+					ctr_grant(i) <= (others => '0');
+					ctr_xact(i) <= (others => '0');
+					ctr_wait(i) <= (others => '0');
+				else
+					if grant(i) = '1' and grant_d(i) = '0' then
+						ctr_grant(i) <= ctr_grant(i) + 1;
+					end if;
+					if grant(i) = '1' and (ipb_in.ipb_ack = '1' or ipb_in.ipb_err = '1') then
+						ctr_xact(i) <= ctr_xact(i) + 1;
+					end if;
+					if ipb_req(i) = '1' and grant(i) = '0' then
+						ctr_wait(i) <= ctr_wait(i) + 1;
+					end if;
+				end if;
+			end if;
+		end process;
+
+		stat(3 * i) <= std_logic_vector(ctr_grant(i));
+		stat(3 * i + 1) <= std_logic_vector(ctr_xact(i));
+		stat(3 * i + 2) <= std_logic_vector(ctr_wait(i));
+
+	end generate;
+
+	ipb_grant <= grant;
+
+end rtl;
@@ -0,0 +1,377 @@
+-- ipbus_i2c_trace
+--
+-- Passive trace of an I2C bus, read over IPbus, so that the I2C traffic of a
+-- live board (e.g. the PROM reads of the NEO430 at boot) can be looked at
+-- without slowing it down with UART prints.
+--
+-- SCL and SDA are synchronised to clk and filtered (a level must be stable for
+-- FILTER clocks). START, repeated START and STOP are SDA edges while SCL is
+-- high. A bit is SDA at the rising edge of SCL, kept at the falling edge
+-- unless a START or STOP came in between; every ninth one, with the eight
+-- before it, makes a byte event with its ACK. The first byte after
+-- a START is marked as the address byte. SCL pulses that do not make up a
+-- whole byte before the next START or STOP (e.g. the nine pulses of a stuck
+-- bus recovery) give a partial event with the number of bits.
+--
+-- Each event is a word in a ring buffer (dual port RAM), with the time since
+-- the previous event. Recording starts at power up, at rst or when armed,
+-- and stops POST events after the trigger, so the ring keeps the history
+-- before it. Trigger 0 (the reset value) is the arm itself: the first
+-- 2**DEPTH_BITS events, i.e. the boot sequence, are kept without any setup.
+-- rst may be tied low so that a reset of IPbus during the boot does not
+-- restart the recording.
+-- See ipbus_i2c_trace.py for a decoder.
+--
+-- Event word:
+--   31..29 type: 1 START, 2 repeated START, 3 STOP, 4 address byte,
+--          5 data byte, 6 partial byte
+--   28     bytes: NACK (the ninth bit)
+--   27..20 bytes: the byte. Partial: the ( last eight ) bits, last one in bit 20
+--   19..16 partial: the number of bits
+--   19..0  otherwise: clocks since the previous event / 2**TS_SHIFT,
+--          0xfffff if that many or more. A partial event is written just
+--          before the START or STOP that ends it, and has that one's time
+--
+-- Memory map (32 bit words, see ipbus_i2c_trace.xml):
+--   0x0 ctrl: bits 2..0 = trigger: 0 arm, 1 START, 2 address byte matching,
+--             3 NACK, 4 partial byte, 7 none (record until stopped)
+--             bit 3 = stop (pause recording), bit 4 = arm (on a change from
+--             0 to 1, so that writes to the other fields do not arm again)
+--             bits 15..8 = byte to match, 23..16 = mask of the bits to match
+--   0x1 events to record from the trigger on, 0 or more than 2**DEPTH_BITS:
+--       2**DEPTH_BITS
+--   0x8 bit 31 = triggered, bit 30 = done, bit 29 = wrapped, bit 28 = SCL,
+--       bit 27 = SDA, bits DEPTH_BITS-1..0 = next ring address
+--   0x9 events recorded since the arm
+--   0xa ring address of the trigger event
+--   0xb time of the trigger event, clocks since the arm / 2**TS_SHIFT
+--   0xc bits 7..0 = DEPTH_BITS, 15..8 = TS_SHIFT, 23..16 = FILTER
+--   0xd CLOCK_SPEED / 1000 (clk in kHz)
+--   2**DEPTH_BITS upwards: the ring
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+use work.ipbus.all;
+use work.ipbus_reg_types.all;
+
+entity ipbus_i2c_trace is
+	generic(
+		DEPTH_BITS: positive := 9; -- 2**DEPTH_BITS events, at least 4 (the registers take the lower half of the address space)
+		TS_SHIFT: natural := 3; -- time unit of 2**TS_SHIFT clocks (256ns at 31.25MHz)
+		FILTER: positive := 4; -- clocks a line level must be stable for
+		CLOCK_SPEED: natural := 31250000 -- of clk, for the decoder
+	);
+	port(
+		ipb_clk: in std_logic;
+		ipb_rst: in std_logic;
+		ipb_in: in ipb_wbus;
+		ipb_out: out ipb_rbus;
+		clk: in std_logic;
+		rst: in std_logic;
+		scl_i: in std_logic; -- the state of the lines, as inputs only
+		sda_i: in std_logic
+	);
+
+end ipbus_i2c_trace;
+
+architecture rtl of ipbus_i2c_trace is
+
+	constant N_STAT: positive := 6;
+	constant DEPTH: positive := 2 ** DEPTH_BITS;
+	constant DT_MAX: unsigned(19 downto 0) := (others => '1');
+
+	constant EV_START: std_logic_vector(2 downto 0) := "001";
+	constant EV_RESTART: std_logic_vector(2 downto 0) := "010";
+	constant EV_STOP: std_logic_vector(2 downto 0) := "011";
+	constant EV_ADDR: std_logic_vector(2 downto 0) := "100";
+	constant EV_DATA: std_logic_vector(2 downto 0) := "101";
+	constant EV_PARTIAL: std_logic_vector(2 downto 0) := "110";
+
+	constant TRIG_ARM: natural := 0;
+	constant TRIG_START: natural := 1;
+	constant TRIG_ADDR: natural := 2;
+	constant TRIG_NACK: natural := 3;
+	constant TRIG_PARTIAL: natural := 4;
+
+	signal ctrl: ipb_reg_v(1 downto 0);
+	signal stat: ipb_reg_v(N_STAT - 1 downto 0);
+	signal stb: std_logic_vector(1 downto 0);
+	signal ipbw: ipb_wbus_array(1 downto 0);
+	signal ipbr: ipb_rbus_array(1 downto 0);
+	signal sel: std_logic_vector(0 downto 0);
+
+	signal trig_mode: natural range 0 to 7;
+	signal match, mask: std_logic_vector(7 downto 0);
+	signal post: unsigned(DEPTH_BITS downto 0);
+	signal pause, arm: std_logic;
+	signal arm_d: std_logic := '0';
+
+	signal scl_s, sda_s: std_logic_vector(1 downto 0) := "11";
+	signal scl_f, sda_f, scl_d, sda_d: std_logic := '1';
+	signal scl_n, sda_n: natural range 0 to FILTER := 0;
+
+	signal in_xfer, addr_next, bit_ok, bit_v: std_logic := '0';
+	signal nbits: unsigned(3 downto 0) := (others => '0');
+	signal sr: std_logic_vector(8 downto 0) := (others => '0');
+	signal pend: std_logic := '0';
+	signal pend_type: std_logic_vector(2 downto 0);
+
+	signal t: unsigned(31 downto 0) := (others => '0'); -- clocks since the arm
+	signal t_last: unsigned(31 downto 0) := (others => '0'); -- at the previous event, in time units
+	signal wptr, trig_ptr: unsigned(DEPTH_BITS - 1 downto 0) := (others => '0');
+	signal n_ev, trig_t: unsigned(31 downto 0) := (others => '0');
+	signal left: unsigned(DEPTH_BITS downto 0) := to_unsigned(DEPTH, DEPTH_BITS + 1); -- as armed with trigger 0
+	signal triggered: std_logic := '1';
+	signal done, wrapped: std_logic := '0';
+	signal r_we: std_logic := '0';
+	signal r_d: std_logic_vector(31 downto 0);
+	signal r_addr: std_logic_vector(DEPTH_BITS - 1 downto 0);
+
+begin
+
+-- IPbus side: registers in the lower half of the address space, ring in the upper
+
+	sel(0) <= ipb_in.ipb_addr(DEPTH_BITS);
+
+	fabric: entity work.ipbus_fabric_sel
+		generic map(
+			NSLV => 2,
+			SEL_WIDTH => 1
+		)
+		port map(
+			sel => sel,
+			ipb_in => ipb_in,
+			ipb_out => ipb_out,
+			ipb_to_slaves => ipbw,
+			ipb_from_slaves => ipbr
+		);
+
+	csr: entity work.ipbus_syncreg_v
+		generic map(
+			N_CTRL => 2,
+			N_STAT => N_STAT
+		)
+		port map(
+			clk => ipb_clk,
+			rst => ipb_rst,
+			ipb_in => ipbw(0),
+			ipb_out => ipbr(0),
+			slv_clk => clk,
+			d => stat,
+			q => ctrl,
+			stb => stb,
+			rstb => open
+		);
+
+	trig_mode <= to_integer(unsigned(ctrl(0)(2 downto 0)));
+	pause <= ctrl(0)(3);
+	arm <= ctrl(0)(4) and not arm_d;
+	match <= ctrl(0)(15 downto 8);
+	mask <= ctrl(0)(23 downto 16);
+	post <= to_unsigned(DEPTH, DEPTH_BITS + 1) when unsigned(ctrl(1)) = 0 or unsigned(ctrl(1)) > DEPTH else
+		resize(unsigned(ctrl(1)), DEPTH_BITS + 1);
+
+-- Arm on the rising edge of the bit only: a masked write of another field rewrites the whole register
+
+	process(clk)
+	begin
+		if rising_edge(clk) then
+			arm_d <= ctrl(0)(4);
+		end if;
+	end process;
+
+	ring: entity work.ipbus_dpram
+		generic map(
+			ADDR_WIDTH => DEPTH_BITS
+		)
+		port map(
+			clk => ipb_clk,
+			rst => ipb_rst,
+			ipb_in => ipbw(1),
+			ipb_out => ipbr(1),
+			rclk => clk,
+			we => r_we,
+			d => r_d,
+			q => open,
+			addr => r_addr
+		);
+
+-- Lines: synchronised, then a new level is taken once it has been stable for FILTER clocks
+
+	lines: process(clk)
+	begin
+		if rising_edge(clk) then
+			scl_s <= scl_s(0) & scl_i;
+			sda_s <= sda_s(0) & sda_i;
+			if scl_s(1) = scl_f then
+				scl_n <= 0;
+			elsif scl_n = FILTER - 1 then
+				scl_f <= scl_s(1);
+				scl_n <= 0;
+			else
+				scl_n <= scl_n + 1;
+			end if;
+			if sda_s(1) = sda_f then
+				sda_n <= 0;
+			elsif sda_n = FILTER - 1 then
+				sda_f <= sda_s(1);
+				sda_n <= 0;
+			else
+				sda_n <= sda_n + 1;
+			end if;
+			scl_d <= scl_f;
+			sda_d <= sda_f;
+		end if;
+	end process;
+
+-- Events, and the ring. A partial byte and the START / STOP that ends it come in the same clock:
+-- the START / STOP is written on the next ( the lines can't make another event that soon )
+
+	events: process(clk)
+		variable ev_valid, hit: boolean;
+		variable ev_type: std_logic_vector(2 downto 0);
+		variable ev_data: std_logic_vector(8 downto 0);
+		variable ev_bits: unsigned(3 downto 0);
+		variable tu, dt: unsigned(31 downto 0);
+		variable ev: std_logic_vector(31 downto 0);
+	begin
+		if rising_edge(clk) then
+			r_we <= '0';
+			tu := shift_right(t, TS_SHIFT);
+			if rst = '1' or arm = '1' then
+				t <= (others => '0');
+				t_last <= (others => '0');
+				wptr <= (others => '0');
+				n_ev <= (others => '0');
+				wrapped <= '0';
+				done <= '0';
+				pend <= '0';
+				if trig_mode = TRIG_ARM then
+					triggered <= '1';
+					trig_ptr <= (others => '0');
+					trig_t <= (others => '0');
+					left <= post;
+				else
+					triggered <= '0';
+				end if;
+				in_xfer <= '0';
+				nbits <= (others => '0');
+				bit_ok <= '0';
+			else
+				t <= t + 1;
+				ev_valid := false;
+				ev_data := (others => '0');
+				ev_bits := (others => '0');
+
+				if pend = '1' then
+					ev_valid := true;
+					ev_type := pend_type;
+					pend <= '0';
+				end if;
+
+				if scl_f = '1' and scl_d = '1' and sda_f /= sda_d then
+					-- START / STOP, after any partial byte
+					if sda_f = '0' then
+						ev_type := EV_START;
+						if in_xfer = '1' then
+							ev_type := EV_RESTART;
+						end if;
+						in_xfer <= '1';
+						addr_next <= '1';
+					else
+						ev_type := EV_STOP;
+						in_xfer <= '0';
+						addr_next <= '0';
+					end if;
+					if nbits /= 0 then
+						pend <= '1';
+						pend_type <= ev_type;
+						ev_type := EV_PARTIAL;
+						ev_data := sr(7 downto 0) & '0';
+						ev_bits := nbits;
+					end if;
+					ev_valid := true;
+					nbits <= (others => '0');
+					bit_ok <= '0';
+				elsif scl_f = '1' and scl_d = '0' then
+					bit_v <= sda_f;
+					bit_ok <= '1';
+				elsif scl_f = '0' and scl_d = '1' and bit_ok = '1' then
+					-- a bit, complete
+					bit_ok <= '0';
+					sr <= sr(7 downto 0) & bit_v;
+					if nbits = 8 and in_xfer = '1' then
+						ev_valid := true;
+						ev_type := EV_DATA;
+						if addr_next = '1' then
+							ev_type := EV_ADDR;
+						end if;
+						ev_data := sr(7 downto 0) & bit_v;
+						addr_next <= '0';
+						nbits <= (others => '0');
+					elsif nbits /= 15 then
+						nbits <= nbits + 1;
+					end if;
+				end if;
+
+				if ev_valid and pause /= '1' and done = '0' then
+					ev := ev_type & ev_data(0) & ev_data(8 downto 1) & std_logic_vector(DT_MAX);
+					if ev_type = EV_PARTIAL then
+						ev(19 downto 0) := std_logic_vector(ev_bits) & x"0000";
+						ev(27 downto 20) := ev_data(8 downto 1);
+						ev(28) := '0';
+					else
+						dt := tu - t_last;
+						if dt < DT_MAX then
+							ev(19 downto 0) := std_logic_vector(dt(19 downto 0));
+						end if;
+						t_last <= tu;
+					end if;
+
+					case trig_mode is
+					when TRIG_START => hit := ev_type = EV_START or ev_type = EV_RESTART;
+					when TRIG_ADDR => hit := ev_type = EV_ADDR and ((ev_data(8 downto 1) xor match) and mask) = x"00";
+					when TRIG_NACK => hit := (ev_type = EV_ADDR or ev_type = EV_DATA) and ev_data(0) = '1';
+					when TRIG_PARTIAL => hit := ev_type = EV_PARTIAL;
+					when others => hit := false;
+					end case;
+
+					r_we <= '1';
+					r_d <= ev;
+					r_addr <= std_logic_vector(wptr);
+					wptr <= wptr + 1;
+					if wptr = DEPTH - 1 then
+						wrapped <= '1';
+					end if;
+					n_ev <= n_ev + 1;
+
+					if triggered = '1' then
+						if left = 1 then
+							done <= '1';
+						end if;
+						left <= left - 1;
+					elsif hit then
+						triggered <= '1';
+						trig_ptr <= wptr;
+						trig_t <= tu;
+						if post = 1 then
+							done <= '1';
+						end if;
+						left <= post - 1;
+					end if;
+				end if;
+			end if;
+		end if;
+	end process;
+
+	stat(0) <= triggered & done & wrapped & scl_f & sda_f & std_logic_vector(to_unsigned(0, 27 - DEPTH_BITS)) & std_logic_vector(wptr);
+	stat(1) <= std_logic_vector(n_ev);
+	stat(2) <= std_logic_vector(resize(trig_ptr, 32));
+	stat(3) <= std_logic_vector(trig_t);
+	stat(4) <= x"00" & std_logic_vector(to_unsigned(FILTER, 8)) & std_logic_vector(to_unsigned(TS_SHIFT, 8)) &
+		std_logic_vector(to_unsigned(DEPTH_BITS, 8));
+	stat(5) <= std_logic_vector(to_unsigned(CLOCK_SPEED / 1000, 32));
+
+end rtl;
@@ -0,0 +1,398 @@
+-- ipbus_latency_hist
+--
+-- Request to response latency of the IPbus packets going through ipbus_ctrl,
+-- measured on its MAC side (mac_clk) by watching the frames, so that it can be
+-- profiled under normal traffic.
+--
+-- A received frame is a request if it is addressed to mac_addr, is IPv4 / UDP
+-- to IPBUS_PORT and carries an IPbus 2.0 control packet header (big-endian, as
+-- sent by uHAL). The time of its first byte and its packet ID are queued. A
+-- transmitted control packet from IPBUS_PORT is matched against the queue by
+-- packet ID, and the latency is the time from the first byte of the request to
+-- the last byte of the response. ipbus_ctrl answers in order, so the requests
+-- queued ahead of the match were never answered (dropped) and are discarded. A
+-- response with no request in the queue (e.g. a resend) is counted and ignored.
+--
+-- Latencies are binned into a histogram of 2**HIST_BITS 32-bit counts, each
+-- bin 2**BIN_SHIFT mac_clk cycles wide (the last one also takes everything
+-- beyond). The histogram is a dual port RAM read over IPbus. The count, sum,
+-- min and max of the latencies are kept beside it. All of it is cleared at
+-- rst_macclk or on request.
+--
+-- Memory map (32 bit words, see ipbus_latency_hist.xml):
+--   0x00 ctrl: bit 0 = freeze (stop recording, to read a consistent set),
+--              bit 1 = clear (on a change from 0 to 1, so that writes to freeze
+--              that leave it set do not clear again; takes 2**HIST_BITS mac_clk cycles)
+--   0x10 count of latencies recorded
+--   0x11, 0x12 sum of the latencies (mac_clk cycles), low and high words
+--   0x13 min latency (0xffffffff until the first), 0x14 max latency
+--   0x15 requests never answered, 0x16 responses without a request,
+--   0x17 requests not queued (more than 2**QUEUE_BITS in flight)
+--   0x18 bits 7..0 = BIN_SHIFT, 15..8 = HIST_BITS, 23..16 = QUEUE_BITS,
+--        bit 31 = clear in progress
+--   2**HIST_BITS upwards: the histogram, bin 0 first
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+use work.ipbus.all;
+use work.ipbus_reg_types.all;
+
+entity ipbus_latency_hist is
+	generic(
+		IPBUS_PORT: natural := 50001;
+		HIST_BITS: positive := 10; -- 2**HIST_BITS bins, at least 5 (the registers take the lower half of the address space)
+		BIN_SHIFT: natural := 4; -- bin width of 2**BIN_SHIFT mac_clk cycles (128ns at 125MHz)
+		QUEUE_BITS: positive := 3 -- up to 2**QUEUE_BITS requests in flight are matched
+	);
+	port(
+		ipb_clk: in std_logic;
+		ipb_rst: in std_logic;
+		ipb_in: in ipb_wbus;
+		ipb_out: out ipb_rbus;
+		mac_clk: in std_logic;
+		rst_macclk: in std_logic;
+		mac_addr: in std_logic_vector(47 downto 0); -- as given to ipbus_ctrl
+		mac_rx_data: in std_logic_vector(7 downto 0); -- the MAC interface of ipbus_ctrl, as inputs only
+		mac_rx_valid: in std_logic;
+		mac_rx_last: in std_logic;
+		mac_rx_error: in std_logic;
+		mac_tx_data: in std_logic_vector(7 downto 0);
+		mac_tx_valid: in std_logic;
+		mac_tx_last: in std_logic;
+		mac_tx_error: in std_logic;
+		mac_tx_ready: in std_logic
+	);
+
+end ipbus_latency_hist;
+
+architecture rtl of ipbus_latency_hist is
+
+	constant N_STAT: positive := 9;
+	constant N_BINS: positive := 2 ** HIST_BITS;
+	constant PORT_V: std_logic_vector(15 downto 0) := std_logic_vector(to_unsigned(IPBUS_PORT, 16));
+	constant HDR_LAST: natural := 45; -- last byte of the IPbus packet header
+
+	-- Whether byte pos of a frame fits an IPbus 2.0 control packet in Ethernet / IPv4 / UDP.
+	-- port_pos is the UDP port to match (34 = source, 36 = destination).
+	-- The packet ID (bytes 43 and 44) is taken, not checked.
+	function hdr_ok(pos: natural; b: std_logic_vector(7 downto 0); port_pos: natural; mac: std_logic_vector(47 downto 0); check_mac: boolean) return boolean is
+	begin
+		for i in 0 to 5 loop
+			if pos = i then
+				return not check_mac or b = mac(47 - 8 * i downto 40 - 8 * i);
+			end if;
+		end loop;
+		if pos = 12 then
+			return b = x"08"; -- IPv4
+		elsif pos = 13 then
+			return b = x"00";
+		elsif pos = 14 then
+			return b = x"45"; -- no IP options, as ipbus_ctrl
+		elsif pos = 23 then
+			return b = x"11"; -- UDP
+		elsif pos = port_pos then
+			return b = PORT_V(15 downto 8);
+		elsif pos = port_pos + 1 then
+			return b = PORT_V(7 downto 0);
+		elsif pos = 42 then
+			return b = x"20"; -- version 2.0
+		elsif pos = HDR_LAST then
+			return b = x"f0"; -- big-endian control packet
+		end if;
+		return true;
+	end function;
+
+	type id_array_t is array(2 ** QUEUE_BITS - 1 downto 0) of std_logic_vector(15 downto 0);
+	type ts_array_t is array(2 ** QUEUE_BITS - 1 downto 0) of unsigned(31 downto 0);
+
+	signal ctrl: ipb_reg_v(0 downto 0);
+	signal stat: ipb_reg_v(N_STAT - 1 downto 0);
+	signal stb: std_logic_vector(0 downto 0);
+	signal clr_d: std_logic := '0';
+	signal ipbw: ipb_wbus_array(1 downto 0);
+	signal ipbr: ipb_rbus_array(1 downto 0);
+	signal sel: std_logic_vector(0 downto 0);
+
+	signal ts: unsigned(31 downto 0) := (others => '0');
+	signal rx_pos, tx_pos: integer range 0 to HDR_LAST + 1 := 0;
+	signal rx_ok, tx_ok, rx_req, tx_resp: std_logic := '0';
+	signal rx_id, tx_id: std_logic_vector(15 downto 0);
+	signal rx_ts, tx_ts: unsigned(31 downto 0);
+
+	signal q_id: id_array_t;
+	signal q_ts: ts_array_t;
+	signal q_wr, q_rd: unsigned(QUEUE_BITS downto 0) := (others => '0'); -- one bit more, for full / empty
+	signal pend: std_logic := '0';
+	signal pend_id: std_logic_vector(15 downto 0);
+	signal pend_ts: unsigned(31 downto 0);
+	signal lat: unsigned(31 downto 0);
+	signal lat_valid, lost, orphan, overflow: std_logic := '0';
+
+	signal freeze, clr, clearing, h_s0, h_s1, h_we: std_logic := '0';
+	signal h_addr: unsigned(HIST_BITS - 1 downto 0) := (others => '0');
+	signal h_d, h_q: std_logic_vector(31 downto 0);
+	signal ctr_lat, ctr_lost, ctr_orphan, ctr_overflow, lat_min, lat_max: unsigned(31 downto 0);
+	signal lat_sum: unsigned(63 downto 0);
+
+begin
+
+-- IPbus side: registers in the lower half of the address space, histogram in the upper
+
+	sel(0) <= ipb_in.ipb_addr(HIST_BITS);
+
+	fabric: entity work.ipbus_fabric_sel
+		generic map(
+			NSLV => 2,
+			SEL_WIDTH => 1
+		)
+		port map(
+			sel => sel,
+			ipb_in => ipb_in,
+			ipb_out => ipb_out,
+			ipb_to_slaves => ipbw,
+			ipb_from_slaves => ipbr
+		);
+
+	csr: entity work.ipbus_syncreg_v
+		generic map(
+			N_CTRL => 1,
+			N_STAT => N_STAT
+		)
+		port map(
+			clk => ipb_clk,
+			rst => ipb_rst,
+			ipb_in => ipbw(0),
+			ipb_out => ipbr(0),
+			slv_clk => mac_clk,
+			d => stat,
+			q => ctrl,
+			stb => stb,
+			rstb => open
+		);
+
+	freeze <= ctrl(0)(0);
+
+-- Clear on the rising edge of the bit only: a masked write of freeze rewrites the whole register
+
+	process(mac_clk)
+	begin
+		if rising_edge(mac_clk) then
+			clr_d <= ctrl(0)(1);
+		end if;
+	end process;
+
+	clr <= ctrl(0)(1) and not clr_d;
+
+	hist: entity work.ipbus_dpram
+		generic map(
+			ADDR_WIDTH => HIST_BITS
+		)
+		port map(
+			clk => ipb_clk,
+			rst => ipb_rst,
+			ipb_in => ipbw(1),
+			ipb_out => ipbr(1),
+			rclk => mac_clk,
+			we => h_we,
+			d => h_d,
+			q => h_q,
+			addr => std_logic_vector(h_addr)
+		);
+
+-- Frames: the time of the first byte of a request, the time of the last byte of a response
+
+	process(mac_clk)
+	begin
+		if rising_edge(mac_clk) then
+			ts <= ts + 1;
+		end if;
+	end process;
+
+	rx: process(mac_clk)
+		variable ok: std_logic;
+	begin
+		if rising_edge(mac_clk) then
+			rx_req <= '0';
+			if rst_macclk = '1' then
+				rx_pos <= 0;
+			elsif mac_rx_valid = '1' then
+				ok := rx_ok;
+				if rx_pos = 0 then
+					rx_ts <= ts;
+					ok := '1';
+				end if;
+				if not hdr_ok(rx_pos, mac_rx_data, 36, mac_addr, true) then
+					ok := '0';
+				end if;
+				if rx_pos = 43 then
+					rx_id(15 downto 8) <= mac_rx_data;
+				elsif rx_pos = 44 then
+					rx_id(7 downto 0) <= mac_rx_data;
+				end if;
+				rx_ok <= ok;
+				if mac_rx_last = '1' then
+					if rx_pos >= HDR_LAST and mac_rx_error = '0' then
+						rx_req <= ok;
+					end if;
+					rx_pos <= 0;
+				elsif rx_pos /= HDR_LAST + 1 then
+					rx_pos <= rx_pos + 1;
+				end if;
+			end if;
+		end if;
+	end process;
+
+	tx: process(mac_clk)
+		variable ok: std_logic;
+	begin
+		if rising_edge(mac_clk) then
+			tx_resp <= '0';
+			if rst_macclk = '1' then
+				tx_pos <= 0;
+			elsif mac_tx_valid = '1' and mac_tx_ready = '1' then
+				ok := tx_ok;
+				if tx_pos = 0 then
+					ok := '1';
+				end if;
+				if not hdr_ok(tx_pos, mac_tx_data, 34, mac_addr, false) then
+					ok := '0';
+				end if;
+				if tx_pos = 43 then
+					tx_id(15 downto 8) <= mac_tx_data;
+				elsif tx_pos = 44 then
+					tx_id(7 downto 0) <= mac_tx_data;
+				end if;
+				tx_ok <= ok;
+				if mac_tx_last = '1' then
+					if tx_pos >= HDR_LAST and mac_tx_error = '0' then
+						tx_resp <= ok;
+					end if;
+					tx_ts <= ts;
+					tx_pos <= 0;
+				elsif tx_pos /= HDR_LAST + 1 then
+					tx_pos <= tx_pos + 1;
+				end if;
+			end if;
+		end if;
+	end process;
+
+-- Requests in flight. A response is looked for one queue entry per cycle; responses are far
+-- enough apart (a minimum size frame) to get through the whole queue before the next one.
+
+	match: process(mac_clk)
+	begin
+		if rising_edge(mac_clk) then
+			lat_valid <= '0';
+			lost <= '0';
+			orphan <= '0';
+			overflow <= '0';
+			if rst_macclk = '1' or clr = '1' then
+				q_wr <= (others => '0');
+				q_rd <= (others => '0');
+				pend <= '0';
+			else
+				if rx_req = '1' then
+					if q_wr - q_rd = 2 ** QUEUE_BITS then
+						overflow <= '1';
+					else
+						q_id(to_integer(q_wr(QUEUE_BITS - 1 downto 0))) <= rx_id;
+						q_ts(to_integer(q_wr(QUEUE_BITS - 1 downto 0))) <= rx_ts;
+						q_wr <= q_wr + 1;
+					end if;
+				end if;
+				if tx_resp = '1' then
+					pend <= '1';
+					pend_id <= tx_id;
+					pend_ts <= tx_ts;
+				elsif pend = '1' then
+					if q_wr = q_rd then
+						orphan <= '1';
+						pend <= '0';
+					else
+						if q_id(to_integer(q_rd(QUEUE_BITS - 1 downto 0))) = pend_id then
+							lat <= pend_ts - q_ts(to_integer(q_rd(QUEUE_BITS - 1 downto 0)));
+							lat_valid <= '1';
+							pend <= '0';
+						else
+							lost <= '1';
+						end if;
+						q_rd <= q_rd + 1;
+					end if;
+				end if;
+			end if;
+		end if;
+	end process;
+
+-- Statistics, and read-modify-write of the histogram bin (the RAM reads a cycle after the address)
+
+	stats: process(mac_clk)
+	begin
+		if rising_edge(mac_clk) then
+			h_s0 <= '0';
+			h_s1 <= h_s0;
+			if rst_macclk = '1' or clr = '1' then
+				clearing <= '1';
+				h_addr <= (others => '0');
+				h_s0 <= '0';
+				h_s1 <= '0';
+				ctr_lat <= (others => '0');
+				ctr_lost <= (others => '0');
+				ctr_orphan <= (others => '0');
+				ctr_overflow <= (others => '0');
+				lat_sum <= (others => '0');
+				lat_min <= (others => '1');
+				lat_max <= (others => '0');
+			elsif clearing = '1' then
+				if h_addr = N_BINS - 1 then
+					clearing <= '0';
+				end if;
+				h_addr <= h_addr + 1;
+			elsif freeze = '0' then
+				if lat_valid = '1' then
+					ctr_lat <= ctr_lat + 1;
+					lat_sum <= lat_sum + lat;
+					if lat < lat_min then
+						lat_min <= lat;
+					end if;
+					if lat > lat_max then
+						lat_max <= lat;
+					end if;
+					if shift_right(lat, BIN_SHIFT) >= N_BINS then
+						h_addr <= (others => '1');
+					else
+						h_addr <= resize(shift_right(lat, BIN_SHIFT), HIST_BITS);
+					end if;
+					h_s0 <= '1';
+				end if;
+				if lost = '1' then
+					ctr_lost <= ctr_lost + 1;
+				end if;
+				if orphan = '1' then
+					ctr_orphan <= ctr_orphan + 1;
+				end if;
+				if overflow = '1' then
+					ctr_overflow <= ctr_overflow + 1;
+				end if;
+			end if;
+		end if;
+	end process;
+
+	h_we <= clearing or h_s1;
+	h_d <= (others => '0') when clearing = '1' else
+		h_q when h_q = x"ffffffff" else
+		std_logic_vector(unsigned(h_q) + 1);
+
+	stat(0) <= std_logic_vector(ctr_lat);
+	stat(1) <= std_logic_vector(lat_sum(31 downto 0));
+	stat(2) <= std_logic_vector(lat_sum(63 downto 32));
+	stat(3) <= std_logic_vector(lat_min);
+	stat(4) <= std_logic_vector(lat_max);
+	stat(5) <= std_logic_vector(ctr_lost);
+	stat(6) <= std_logic_vector(ctr_orphan);
+	stat(7) <= std_logic_vector(ctr_overflow);
+	stat(8) <= clearing & "0000000" & std_logic_vector(to_unsigned(QUEUE_BITS, 8)) &
+		std_logic_vector(to_unsigned(HIST_BITS, 8)) & std_logic_vector(to_unsigned(BIN_SHIFT, 8));
+
+end rtl;
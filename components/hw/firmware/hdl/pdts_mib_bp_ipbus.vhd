@@ -7,6 +7,9 @@ use work.ipbus_reg_types.all;
 use work.ipbus_decode_top_mib_gbe_bp.all;
 
 entity mib_bp_ipbus is
+    generic(
+        SHARED_BUS      : boolean := False -- True: export the master bus for arbitration and serve config on ipb_cfg_in / ipb_cfg_out
+    );
     port(
         ipb_clk         : in std_logic;
         rst_125         : in std_logic;
@@ -29,7 +32,13 @@ entity mib_bp_ipbus is
         user_clk                : in std_logic;
         gtrefclk_out            : in std_logic;
         mmcm_locked             : in std_logic;
-        bp_eth_locked           : out std_logic
+        bp_eth_locked           : out std_logic;
+        ipb_out         : out ipb_wbus; -- ipbus master bus of the backplane controller
+        ipb_in          : in ipb_rbus;
+        ipb_req         : out std_logic; -- bus request / grant, to be arbitrated against other masters
+        ipb_grant       : in std_logic := '1';
+        ipb_cfg_in      : in ipb_wbus := IPB_WBUS_NULL; -- config register, when SHARED_BUS
+        ipb_cfg_out     : out ipb_rbus
     );
 
 end entity mib_bp_ipbus;
@@ -39,11 +48,16 @@ architecture rtl of mib_bp_ipbus is
     -- IPBus controller bus (before fabric select)
     signal ipb_ctrl_in    : ipb_rbus;
     signal ipb_ctrl_out   : ipb_wbus;
+    signal ipb_ctrl_req, ipb_ctrl_grant : std_logic;
     
     -- IPBus slave buses (after fabric select)
     signal ipbw: ipb_wbus_array(N_SLAVES - 1 downto 0);
     signal ipbr: ipb_rbus_array(N_SLAVES - 1 downto 0);
     
+    -- Config register bus, from the private fabric or from ipb_cfg_in
+    signal ipb_config_in  : ipb_wbus;
+    signal ipb_config_out : ipb_rbus;
+    
     -- Axi stream interface from MAC.
     signal mac_tx_data, mac_rx_data: std_logic_vector(7 downto 0);
     signal mac_tx_valid, mac_tx_last, mac_tx_error, mac_tx_ready, mac_rx_valid, mac_rx_last, mac_rx_error: std_logic;
@@ -105,25 +119,47 @@ begin
             mac_tx_ready => mac_tx_ready,
             ipb_out      => ipb_ctrl_out,
             ipb_in       => ipb_ctrl_in,
+            ipb_req      => ipb_ctrl_req,
+            ipb_grant    => ipb_ctrl_grant,
             RARP_select  => '0',                -- Using static IP
             mac_addr     => X"020ddba1164f",    -- 02:0d:db:a1:16:4f
             ip_addr      => X"c0a879c7",        -- 192.168.121.199
             pkt          => open
         );
-        
--- ipbus address decode
-    bp_ipb_fabric: entity work.ipbus_fabric_sel
-        generic map(
-            NSLV => N_SLAVES,
-            SEL_WIDTH => IPBUS_SEL_WIDTH
-        )
-        port map(
-            ipb_in => ipb_ctrl_out,
-            ipb_out => ipb_ctrl_in,
-            sel => ipbus_sel_top_mib_gbe_bp(ipb_ctrl_out.ipb_addr),
-            ipb_to_slaves => ipbw,
-            ipb_from_slaves => ipbr
-        );
+
+-- Shared: the controller goes out to the arbiter, config is a slave of the shared fabric
+    gen_shared: if SHARED_BUS generate
+        ipb_out <= ipb_ctrl_out;
+        ipb_ctrl_in <= ipb_in;
+        ipb_req <= ipb_ctrl_req;
+        ipb_ctrl_grant <= ipb_grant;
+        ipb_config_in <= ipb_cfg_in;
+        ipb_cfg_out <= ipb_config_out;
+    end generate gen_shared;
+
+-- Private: the controller only sees its own fabric ( top_mib_gbe_bp.xml )
+    gen_private: if not SHARED_BUS generate
+        ipb_out <= IPB_WBUS_NULL;
+        ipb_req <= '0';
+        ipb_ctrl_grant <= '1';
+        ipb_cfg_out <= IPB_RBUS_NULL;
+
+        bp_ipb_fabric: entity work.ipbus_fabric_sel
+            generic map(
+                NSLV => N_SLAVES,
+                SEL_WIDTH => IPBUS_SEL_WIDTH
+            )
+            port map(
+                ipb_in => ipb_ctrl_out,
+                ipb_out => ipb_ctrl_in,
+                sel => ipbus_sel_top_mib_gbe_bp(ipb_ctrl_out.ipb_addr),
+                ipb_to_slaves => ipbw,
+                ipb_from_slaves => ipbr
+            );
+
+        ipb_config_in <= ipbw(N_SLV_CONFIG);
+        ipbr(N_SLV_CONFIG) <= ipb_config_out;
+    end generate gen_private;
 
 -- Config info
     bp_ipd_config: entity work.ipbus_roreg_v
@@ -135,7 +171,7 @@ begin
             DATA(7 downto 0)    => X"05"
         )
         port map(
-            ipb_in => ipbw(N_SLV_CONFIG),
-            ipb_out => ipbr(N_SLV_CONFIG)
+            ipb_in => ipb_config_in,
+            ipb_out => ipb_config_out
         );
 end architecture rtl;
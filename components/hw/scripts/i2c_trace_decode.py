@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""
+Decode a dump of the I2C bus trace ( ipbus_i2c_trace ), without uHAL.
+
+ipbus_i2c_trace.py reads the trace over IPBus and decodes it with this module;
+with --save it also writes the raw dump, which can be decoded again here later,
+or on a machine without uHAL:
+
+e.g.
+  python3 ipbus_i2c_trace.py -c file://connections.xml -d board1 read --save boot.json
+  python3 i2c_trace_decode.py boot.json
+  python3 i2c_trace_decode.py boot.json --events
+
+The dump is JSON: {"stat": [ the STAT_WORDS status registers ], "ring": [ the
+whole ring, as read ]}.
+
+A transaction is printed as one line: S = START, Sr = repeated START, P = STOP,
+the address byte as 7 bit address and R/W, the data bytes in hex, each
+followed by + for ACK or - for NACK, and [n: bits] for SCL pulses that did not
+make up a byte ( e.g. the nine of a stuck bus recovery ). Times are from the
+arm, in us; ~ marks those after a gap too long to time.
+
+Event and register layout must match ipbus_i2c_trace.vhd
+"""
+
+import argparse
+import json
+import sys
+
+EV_START = 1
+EV_RESTART = 2
+EV_STOP = 3
+EV_ADDR = 4
+EV_DATA = 5
+EV_PARTIAL = 6
+
+EV_NAMES = {EV_START: 'START', EV_RESTART: 'RESTART', EV_STOP: 'STOP', EV_ADDR: 'ADDR', EV_DATA: 'DATA',
+            EV_PARTIAL: 'PARTIAL'}
+
+DT_MAX = 0xfffff
+
+STAT_WORDS = 6
+
+
+class Trace:
+    """What was read from one trace: its registers and the events, oldest first."""
+
+    def __init__(self, stat, ring):
+        self.triggered = bool(stat[0] >> 31 & 1)
+        self.done = bool(stat[0] >> 30 & 1)
+        self.wrapped = bool(stat[0] >> 29 & 1)
+        self.scl = stat[0] >> 28 & 1
+        self.sda = stat[0] >> 27 & 1
+        self.n_events = stat[1]
+        self.trig_time = stat[3]
+        self.depth_bits = stat[4] & 0xff
+        self.ts_shift = stat[4] >> 8 & 0xff
+        self.clock_khz = stat[5]
+        depth = 1 << self.depth_bits
+        wptr = stat[0] & (depth - 1)
+        trig_ptr = stat[2] & (depth - 1)
+        self.unit_us = (1 << self.ts_shift) * 1000.0 / self.clock_khz
+        if self.wrapped:
+            self.words = list(ring[wptr:]) + list(ring[:wptr])
+            self.trig_index = (trig_ptr - wptr) % depth
+        else:
+            self.words = list(ring[:wptr])
+            self.trig_index = trig_ptr
+        if not self.triggered:
+            self.trig_index = None
+        self.events = self._decode()
+
+    def _decode(self):
+        """ ( type, byte, nack, bits, time in units, exact ) for each event. Partial events take the time of the next one """
+        events = []
+        t = 0
+        exact = not self.wrapped  # the first delta is from the arm, unless it has been overwritten
+        for w in self.words:
+            kind = w >> 29
+            nack = w >> 28 & 1
+            byte = w >> 20 & 0xff
+            bits = 0
+            if kind == EV_PARTIAL:
+                bits = w >> 16 & 0xf
+                nack = 0
+            else:
+                dt = w & DT_MAX
+                if dt == DT_MAX:
+                    exact = False
+                t += dt
+            events.append([kind, byte, nack, bits, t, exact])
+        for i in range(len(events) - 2, -1, -1):
+            if events[i][0] == EV_PARTIAL:
+                events[i][4:6] = events[i + 1][4:6]
+        # Anchor on the trigger, whose time is known, when the start of the recording is lost
+        if self.wrapped and self.trig_index is not None and self.trig_index < len(events):
+            shift = self.trig_time - events[self.trig_index][4]
+            for e in events:
+                e[4] += shift
+        return events
+
+    def time(self, e):
+        return '%s%12.3f' % (' ' if e[5] else '~', e[4] * self.unit_us)
+
+    def dump(self):
+        """One line per event"""
+        lines = []
+        for i, (kind, byte, nack, bits, t, exact) in enumerate(self.events):
+            what = EV_NAMES.get(kind, 'type %d' % kind)
+            if kind in (EV_ADDR, EV_DATA):
+                what += ' 0x%02x %s' % (byte, 'NACK' if nack else 'ACK')
+            elif kind == EV_PARTIAL:
+                what += ' %d bits 0x%02x' % (bits, byte & ((1 << min(bits, 8)) - 1))
+            mark = '  <- trigger' if i == self.trig_index else ''
+            lines.append('%s us  %s%s' % (self.time(self.events[i]), what, mark))
+        return lines
+
+    def transactions(self):
+        """One line per transaction, from a START to the next STOP"""
+        lines = []
+        cur = None
+        for i, e in enumerate(self.events):
+            kind, byte, nack, bits = e[:4]
+            if cur is None:
+                cur = [self.time(e) + ' us ']
+            if kind == EV_START:
+                cur.append('S')
+            elif kind == EV_RESTART:
+                cur.append('Sr')
+            elif kind == EV_STOP:
+                cur.append('P')
+            elif kind == EV_ADDR:
+                cur.append('%02x%s%s' % (byte >> 1, 'R' if byte & 1 else 'W', '-' if nack else '+'))
+            elif kind == EV_DATA:
+                cur.append('%02x%s' % (byte, '-' if nack else '+'))
+            elif kind == EV_PARTIAL:
+                cur.append('[%d: %02x]' % (bits, byte & ((1 << min(bits, 8)) - 1)))
+            else:
+                cur.append('?%d' % kind)
+            if i == self.trig_index:
+                cur[-1] = '*' + cur[-1]
+            if kind == EV_STOP:
+                lines.append(' '.join(cur))
+                cur = None
+        if cur is not None:
+            lines.append(' '.join(cur) + ' ...')
+        return lines
+
+    def summary(self):
+        state = 'done' if self.done else ('triggered' if self.triggered else 'waiting for the trigger')
+        lost = self.n_events - len(self.words)
+        return '%d events recorded, %d kept%s, %s, time unit %.3f us, SCL %d SDA %d' % (
+            self.n_events, len(self.words), ' ( %d overwritten )' % lost if lost > 0 else '', state, self.unit_us,
+            self.scl, self.sda)
+
+
+def save(fname, trace_words):
+    """Write the raw registers and ring ( stat, ring ) as read from the board"""
+    stat, ring = trace_words
+    with open(fname, 'w') as f:
+        json.dump({'stat': list(stat), 'ring': list(ring)}, f)
+        f.write('\n')
+
+
+def load(fname):
+    with open(fname) as f:
+        d = json.load(f)
+    return Trace(d['stat'], d['ring'])
+
+
+def print_trace(trace, events=False):
+    print(trace.summary())
+    for line in (trace.dump() if events else trace.transactions()):
+        print(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('dump', help='JSON dump written by ipbus_i2c_trace.py read --save')
+    parser.add_argument('--events', action='store_true', help='one line per event, instead of per transaction')
+    args = parser.parse_args()
+
+    print_trace(load(args.dump), args.events)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
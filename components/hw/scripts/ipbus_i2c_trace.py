@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+Read and decode the I2C bus trace ( ipbus_i2c_trace, address table
+ipbus_i2c_trace.xml ) of a board, e.g. the PROM reads of the NEO430 at boot.
+
+The trace records from power up by default, so the boot sequence can be read
+as soon as IPBus is up. Devices come from a uHAL connection file; --node is
+the path of the trace in their address table ( by default infra.i2c_trace, as
+in top_te0712.xml of the te0712 example designs ).
+
+e.g.
+  python3 ipbus_i2c_trace.py -c file://connections.xml -d board1 read
+  python3 ipbus_i2c_trace.py -c file://connections.xml -d board1 read --events
+  python3 ipbus_i2c_trace.py -c file://connections.xml -d board1 read --save boot.json
+  python3 ipbus_i2c_trace.py -c file://connections.xml -d board1 arm --trigger nack --post 32
+  python3 ipbus_i2c_trace.py -c file://connections.xml -d board1 arm --trigger addr --match 0xa1 --mask 0xff
+
+The decoding is in i2c_trace_decode.py, which needs no uHAL: --save keeps the
+raw dump, to decode it again there later.
+
+Event and register layout must match ipbus_i2c_trace.vhd
+"""
+
+import argparse
+import sys
+
+from i2c_trace_decode import STAT_WORDS, Trace, print_trace, save
+
+TRIGGERS = {'arm': 0, 'start': 1, 'addr': 2, 'nack': 3, 'partial': 4, 'none': 7}
+
+CTRL_ARM = 0x10
+
+
+def read_trace(node):
+    """Registers, then the ring. If still recording, the ring may be a few events ahead of the registers"""
+    stat = node.getNode('stat').readBlock(STAT_WORDS)
+    node.getClient().dispatch()
+    depth = 1 << (stat[4] & 0xff)
+    ring = node.getNode('ring').readBlock(depth)
+    node.getClient().dispatch()
+    return list(stat), list(ring)
+
+
+def arm(node, trigger, match, mask, post):
+    ctrl = TRIGGERS[trigger] | (match & 0xff) << 8 | (mask & 0xff) << 16
+    node.getNode('post').write(post)
+    # arm is taken on a change from 0 to 1
+    node.getNode('ctrl').write(ctrl)
+    node.getNode('ctrl').write(ctrl | CTRL_ARM)
+    node.getNode('ctrl').write(ctrl)
+    node.getClient().dispatch()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-c', '--connections', required=True, help='uHAL connection file URI')
+    parser.add_argument('-d', '--device', required=True, help='device id')
+    parser.add_argument('--node', default='infra.i2c_trace', help='trace node in the address table ( infra.i2c_trace in top_te0712.xml )')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+    p = sub.add_parser('read', help='read and decode the trace')
+    p.add_argument('--events', action='store_true', help='one line per event, instead of per transaction')
+    p.add_argument('--save', metavar='FILE', help='also write the raw dump, for i2c_trace_decode.py')
+    p = sub.add_parser('arm', help='start recording again')
+    p.add_argument('--trigger', choices=sorted(TRIGGERS, key=TRIGGERS.get), default='arm')
+    p.add_argument('--match', type=lambda s: int(s, 0), default=0, help='address byte ( with R/W ) for --trigger addr')
+    p.add_argument('--mask', type=lambda s: int(s, 0), default=0xfe, help='bits of --match to compare')
+    p.add_argument('--post', type=lambda s: int(s, 0), default=0, help='events to keep from the trigger on, 0: the whole ring')
+    sub.add_parser('stop', help='pause recording')
+    args = parser.parse_args()
+
+    import uhal
+    uhal.setLogLevelTo(uhal.LogLevel.WARNING)
+    cm = uhal.ConnectionManager(args.connections)
+    node = cm.getDevice(args.device).getNode(args.node)
+
+    if args.cmd == 'arm':
+        arm(node, args.trigger, args.match, args.mask, args.post)
+    elif args.cmd == 'stop':
+        node.getNode('ctrl.stop').write(1)
+        node.getClient().dispatch()
+    else:
+        words = read_trace(node)
+        if args.save:
+            save(args.save, words)
+        print_trace(Trace(*words), args.events)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -8,7 +8,8 @@ USE neo430.neo430_package.all;
 ENTITY ipbus_neo430_wrapper IS
   GENERIC( 
     CLOCK_SPEED : natural := 31250000;
-    UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"53" -- Address on I2C bus of E24AA025E
+    UID_I2C_ADDR : std_logic_vector(7 downto 0) := x"53"; -- Address on I2C bus of E24AA025E
+    CDC_OUTPUTS : boolean := false -- hand the address outputs over to mac_clk_i and ipbus_rst_o to ipb_clk ( see below )
     );
   PORT( 
     clk_i      : IN     std_logic;                      -- global clock, rising edge
@@ -24,7 +25,9 @@ ENTITY ipbus_neo430_wrapper IS
     use_rarp_o : OUT    std_logic;                      -- If high then IPBus should use RARP, not fixed IP
     ip_addr_o  : OUT    std_logic_vector(31 downto 0);  -- IP address to give to IPBus core
     mac_addr_o : OUT    std_logic_vector(47 downto 0);  -- MAC address to give to IPBus core
-    ipbus_rst_o: OUT    std_logic                       -- Reset line to IPBus core
+    ipbus_rst_o: OUT    std_logic;                      -- Reset line to IPBus core
+    mac_clk_i  : IN     std_logic := '0';               -- clock of the address outputs, if CDC_OUTPUTS
+    ipb_clk    : IN     std_logic := '0'                -- clock of ipbus_rst_o, if CDC_OUTPUTS
     );
 
 -- Declarations
@@ -48,6 +51,11 @@ architecture rtl of ipbus_neo430_wrapper is
   signal s_pio: std_logic_vector(15 downto 0);
   signal s_i2c_addr : std_logic_vector(2 downto 0); -- need 3 bits for I2C master.
   signal s_ipmac_ni2c_flag : std_logic; -- high if addressing MAC/IP output. Low for I2C
+
+  -- address outputs in the clk_i domain
+  signal s_use_rarp, s_ipbus_rst : std_logic;
+  signal s_ip_addr : std_logic_vector(31 downto 0);
+  signal s_mac_addr : std_logic_vector(47 downto 0);
   
   --attribute mark_debug : string; 
   --attribute mark_debug of  wb_adr_o_int , wb_dat_i_int , wb_dat_o_int , wb_stb_o_int , wb_ack_i_int , s_i2c_ack , s_mac_addr_ack , s_i2c_addr , s_ipmac_ni2c_flag : signal is "true";
@@ -172,11 +180,65 @@ begin  -- architecture rtl
       --
       -- IP , MAC addresses, RARP flag
       --
-      use_rarp_o => use_rarp_o , -- IF IPaddress set to ffffffff or 00000000 then set use_rarp_o flag. 
-      ip_addr_o  => ip_addr_o  , -- IP address to give to IPBus core
-      mac_addr_o => mac_addr_o  ,-- MAC address to give to IPBus core
-      ipbus_rst_o => ipbus_rst_o  -- goes high while CPU is reading MAC, IP/RARP-flag from PROM.
+      use_rarp_o => s_use_rarp , -- IF IPaddress set to ffffffff or 00000000 then set use_rarp_o flag. 
+      ip_addr_o  => s_ip_addr  , -- IP address to give to IPBus core
+      mac_addr_o => s_mac_addr  ,-- MAC address to give to IPBus core
+      ipbus_rst_o => s_ipbus_rst  -- goes high while CPU is reading MAC, IP/RARP-flag from PROM.
       );
 
+  -- Without CDC_OUTPUTS the outputs are in the clk_i domain: clk_i must be the IPBus clock.
+  gen_direct: if not CDC_OUTPUTS generate
+    use_rarp_o    <= s_use_rarp;
+    ip_addr_o     <= s_ip_addr;
+    mac_addr_o    <= s_mac_addr;
+    ipbus_rst_o   <= s_ipbus_rst;
+  end generate gen_direct;
+
+  -- With CDC_OUTPUTS clk_i can be any clock ( e.g. 125MHz ). The addresses and the RARP flag cross to
+  -- mac_clk_i together, and ipbus_rst_o is synchronised to ipb_clk. The IPBus reset is held until
+  -- the addresses have arrived, so the IPBus core never comes out of reset with stale ones.
+  gen_cdc: if CDC_OUTPUTS generate
+    signal s_addr, s_addr_q : std_logic_vector(80 downto 0);
+    signal s_addr_busy : std_logic;
+    signal s_rst_src : std_logic := '1';
+    signal s_rst_sync : std_logic_vector(1 downto 0) := "11";
+    attribute ASYNC_REG : string;
+    attribute ASYNC_REG of s_rst_sync : signal is "TRUE";
+  begin
+    s_addr <= s_use_rarp & s_ip_addr & s_mac_addr;
+
+    cmp_addr_cdc: entity work.neo430_cdc_bus
+      generic map (
+        WIDTH => s_addr'length
+        )
+      port map (
+        clk_i     => clk_i,
+        d_i       => s_addr,
+        busy_o    => s_addr_busy,
+        dst_clk_i => mac_clk_i,
+        q_o       => s_addr_q
+        );
+
+    use_rarp_o    <= s_addr_q(80);
+    ip_addr_o     <= s_addr_q(79 downto 48);
+    mac_addr_o    <= s_addr_q(47 downto 0);
+
+    p_rst_src: process(clk_i)
+    begin
+      if rising_edge(clk_i) then
+        s_rst_src <= s_ipbus_rst or s_addr_busy;
+      end if;
+    end process;
+
+    p_rst_sync: process(ipb_clk)
+    begin
+      if rising_edge(ipb_clk) then
+        s_rst_sync <= s_rst_sync(0) & s_rst_src;
+      end if;
+    end process;
+
+    ipbus_rst_o <= s_rst_sync(1);
+  end generate gen_cdc;
+
 
 end architecture rtl;
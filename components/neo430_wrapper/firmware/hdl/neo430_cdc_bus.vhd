@@ -0,0 +1,80 @@
+--
+-- Hands a bus that changes rarely ( addresses, flags ) over to another clock,
+-- all bits at once.
+--
+-- When d_i differs from the value last sent it is copied to a holding
+-- register and a request toggle crosses to the destination ( two flip-flops ),
+-- which then copies the holding register to q_o and toggles the acknowledge
+-- back the same way. The next value is only taken once the acknowledge is
+-- back, so the holding register is stable whenever the destination copies it;
+-- the path from it to q_o only needs a datapath-only max delay constraint
+-- ( firmware/ucf/neo430_cdc.tcl, with those of the toggles ).
+--
+-- busy_o ( source clock ) is high from a change of d_i until the destination
+-- has it.
+--
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+
+entity neo430_cdc_bus is
+generic (
+    WIDTH : positive
+);
+port (
+    --
+    -- Source side
+    --
+    clk_i     : in  std_logic;
+    d_i       : in  std_logic_vector(WIDTH - 1 downto 0);
+    busy_o    : out std_logic;
+    --
+    -- Destination side
+    --
+    dst_clk_i : in  std_logic;
+    q_o       : out std_logic_vector(WIDTH - 1 downto 0)
+);
+end neo430_cdc_bus;
+
+architecture rtl of neo430_cdc_bus is
+
+    signal s_hold, s_q : std_logic_vector(WIDTH - 1 downto 0) := ( others => '0');
+
+    -- handshake toggles. Not reset, so that neither side can lose or repeat a value
+    signal s_req_tgl, s_ack_tgl : std_logic := '0';
+    signal s_req_sync, s_ack_sync : std_logic_vector(1 downto 0) := "00";
+    signal s_idle : std_logic;
+
+    attribute ASYNC_REG : string;
+    attribute ASYNC_REG of s_req_sync, s_ack_sync : signal is "TRUE";
+
+begin
+
+    s_idle <= '1' when s_req_tgl = s_ack_sync(1) else '0';
+    busy_o <= '0' when s_idle = '1' and d_i = s_hold else '1';
+
+    source_side : process(clk_i)
+    begin
+        if rising_edge(clk_i) then
+            s_ack_sync <= s_ack_sync(0) & s_ack_tgl;
+            if s_idle = '1' and d_i /= s_hold then
+                s_hold    <= d_i;
+                s_req_tgl <= not s_req_tgl;
+            end if;
+        end if;
+    end process source_side;
+
+    destination_side : process(dst_clk_i)
+    begin
+        if rising_edge(dst_clk_i) then
+            s_req_sync <= s_req_sync(0) & s_req_tgl;
+            if s_req_sync(1) /= s_ack_tgl then
+                s_q       <= s_hold;
+                s_ack_tgl <= s_req_sync(1);
+            end if;
+        end if;
+    end process destination_side;
+
+    q_o <= s_q;
+
+end rtl;
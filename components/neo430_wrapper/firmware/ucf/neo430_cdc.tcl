@@ -0,0 +1,19 @@
+# Clock crossings of ipbus_neo430_wrapper with CDC_OUTPUTS ( gen_cdc ).
+#
+# neo430_cdc_bus only lets the destination copy the holding register once the request toggle has
+# been through two flip-flops, and the source only changes it once the acknowledge is back, so these
+# paths need no relation between the clocks. They are only bounded, to one period of clk125 ( the
+# faster side ), so that the copy has settled well before the synchronised toggle allows it to be used.
+
+set neo430_cdc_max_delay 8.000
+
+foreach cdc [get_cells -quiet -hierarchical -filter {NAME =~ *gen_cdc.cmp_addr_cdc}] {
+    set_max_delay -datapath_only -from [get_cells $cdc/s_hold_reg[*]] -to [get_cells $cdc/s_q_reg[*]] $neo430_cdc_max_delay
+    set_max_delay -datapath_only -from [get_cells $cdc/s_req_tgl_reg] -to [get_cells $cdc/s_req_sync_reg[0]] $neo430_cdc_max_delay
+    set_max_delay -datapath_only -from [get_cells $cdc/s_ack_tgl_reg] -to [get_cells $cdc/s_ack_sync_reg[0]] $neo430_cdc_max_delay
+}
+
+# ipbus_rst_o: the reset request into its two flip-flop synchroniser on ipb_clk
+foreach rst [get_cells -quiet -hierarchical -filter {NAME =~ *gen_cdc.s_rst_src_reg}] {
+    set_max_delay -datapath_only -from $rst -to [get_cells [string map {s_rst_src_reg s_rst_sync_reg[0]} $rst]] $neo430_cdc_max_delay
+}
@@ -1,40 +1,262 @@
-#!/usr/bin/env python2
-# Use to pull strings out of neo430_application_image.vhd
-# Run with neo430_application_image.vhd as command line argument. 
-# Pipe into strings to get strings...
-# e.g.
-# python decode_neo430_application_image.py ../../../firmware/hdl/neo430_application_image.vhd | strings
-#
-# David Cussans Nov 2020
-#
-from sys import argv
-from os.path import exists
+#!/usr/bin/env python3
+"""
+Inspect the NEO430 application image ( neo430_application_image_*.vhd ).
+
+Rebuilds the binary from the VHDL init constant and reports how much of the
+instruction memory it uses. If the ELF file from the same build is given
+( main.elf, see Makefile ) the report is broken down per section and per
+function, with the libgcc arithmetic helpers listed separately, and the ELF
+contents are checked against the VHDL image so that a stale image is spotted.
+
+e.g.
+  python3 decode_neo430_application_image.py ../../firmware/hdl/neo430_application_image_macprom.vhd --elf main.elf
+  python3 decode_neo430_application_image.py ../../firmware/hdl/neo430_application_image_macprom.vhd --min-headroom 256
+
+The exit code is non-zero if the image does not leave --min-headroom bytes
+free, so that it can be used in CI.
+
+"make install" also writes a stamp next to the image ( the .vhd name with
+.sha256 instead ), holding the SHA-256 of the image and of the sources it was
+built from: main.c, ../lib and the linker script. --check-stamp recomputes them
+and fails if a source was changed, added or removed without the image being
+rebuilt. The stamp is in sha256sum format, relative to the image directory.
+
+With --raw the binary is written to stdout ( the behaviour of the original
+Python 2 version ), e.g. to pipe into strings.
+
+David Cussans Nov 2020 ( Python 3 rewrite 2026 )
+"""
+
+import argparse
+import glob
+import hashlib
+import os
 import re
+import struct
 import sys
 
-#this to accept parameter from command-line
-script, from_file = argv
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_LINKER_SCRIPT = os.path.join(SCRIPT_DIR, '..', 'common', 'neo430_linker_script.x')
+
+# What the image is built from, besides the neo430 library ( pinned by the submodule )
+SOURCE_GLOBS = ('main.c', '../lib/source/*.c', '../lib/include/*.h', '../common/neo430_linker_script.x')
+DEFAULT_ROM_SIZE = 0x1800
+
+# Sections that make up image.dat, in order ( see Makefile )
+IMAGE_SECTIONS = ('.text', '.rodata', '.data')
+
+MIN_STRING_LENGTH = 4
+
+# libgcc arithmetic helpers: what the 16-bit CPU needs for 32/64-bit shifts, multiplies
+# and divides. 64-bit ones ( e.g. __mspabi_sllll, __mspabi_mpyll, __muldi3 ) should not be
+# linked in at all.
+HELPER_RE = re.compile(r'^__(mspabi_\w+|\w+[ds]i3)$')
+HELPER_64_RE = re.compile(r'^__(mspabi_(s(ll|rl|ra)ll|(mpy|div|rem)\w*ll\w*)|\w+di3)$')
+
+
+def read_image(fname):
+    """Return the application image as bytes ( 16-bit words, little endian )."""
+    with open(fname) as f:
+        text = f.read()
+
+    words = {}
+    for m in re.finditer(r'(\d+)\s*=>\s*x"([0-9a-fA-F]{4})"', text):
+        words[int(m.group(1))] = int(m.group(2), 16)
+
+    if not words:
+        raise ValueError('No application image found in ' + fname)
+
+    n = max(words) + 1
+    return struct.pack('<%dH' % n, *(words.get(i, 0) for i in range(n)))
+
+
+def read_rom_size(fname):
+    """Return the length of the 'rom' region in the linker script."""
+    with open(fname) as f:
+        m = re.search(r'^\s*rom\b.*LENGTH\s*=\s*(0x[0-9a-fA-F]+|\d+)', f.read(), re.MULTILINE)
+    return int(m.group(1), 0) if m else None
+
+
+def stamp_path(image_fname):
+    return os.path.splitext(image_fname)[0] + '.sha256'
+
+
+def sha256(fname):
+    with open(fname, 'rb') as f:
+        return hashlib.sha256(f.read()).hexdigest()
+
+
+def stamp_lines(image_fname):
+    """Return the stamp of the image and its current sources, paths relative to the image directory."""
+    image_dir = os.path.dirname(os.path.abspath(image_fname))
+    files = [os.path.abspath(image_fname)]
+    for pattern in SOURCE_GLOBS:
+        files += sorted(glob.glob(os.path.join(SCRIPT_DIR, pattern)))
+    return ['%s  %s' % (sha256(f), os.path.relpath(os.path.normpath(f), image_dir).replace(os.sep, '/')) for f in files]
+
+
+def write_stamp(image_fname):
+    with open(stamp_path(image_fname), 'w') as f:
+        f.write('\n'.join(stamp_lines(image_fname)) + '\n')
+
+
+def check_stamp(image_fname):
+    """Return the lines of the stamp that differ from the image and sources on disk."""
+    fname = stamp_path(image_fname)
+    if not os.path.exists(fname):
+        return ['no stamp ' + fname]
+    with open(fname) as f:
+        stamp = set(line.strip() for line in f if line.strip())
+    current = set(stamp_lines(image_fname))
+    return ['- ' + line for line in sorted(stamp - current)] + ['+ ' + line for line in sorted(current - stamp)]
+
+
+class Elf32(object):
+    """Just enough of an ELF32 little-endian reader for section and symbol sizes."""
+
+    STT_OBJECT = 1
+    STT_FUNC = 2
+
+    def __init__(self, fname):
+        with open(fname, 'rb') as f:
+            self.data = f.read()
+
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError(fname + ' is not a 32-bit little-endian ELF file')
+
+        (shoff,) = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', self.data, 0x2e)
+
+        headers = [struct.unpack_from('<IIIIIIIIII', self.data, shoff + i * shentsize) for i in range(shnum)]
+        shstr = headers[shstrndx]
+
+        self.sections = []
+        for (name, stype, flags, addr, offset, size, link, info, align, entsize) in headers:
+            self.sections.append({
+                'name': self._str(shstr[4], name), 'type': stype, 'addr': addr,
+                'offset': offset, 'size': size, 'link': link, 'entsize': entsize,
+            })
+
+    def _str(self, offset, index):
+        end = self.data.index(b'\0', offset + index)
+        return self.data[offset + index:end].decode('ascii', 'replace')
+
+    def section(self, name):
+        for s in self.sections:
+            if s['name'] == name:
+                return s
+        return None
+
+    def contents(self, name):
+        s = self.section(name)
+        if s is None or s['type'] == 8:  # SHT_NOBITS
+            return b''
+        return self.data[s['offset']:s['offset'] + s['size']]
+
+    def symbols(self):
+        """Yield ( name, type, address, size, section name ) for each sized symbol."""
+        symtab = self.section('.symtab')
+        if symtab is None:
+            return
+        strtab = self.sections[symtab['link']]
+        for i in range(symtab['size'] // 16):
+            name, value, size, info, other, shndx = struct.unpack_from('<IIIBBH', self.data, symtab['offset'] + 16 * i)
+            if size == 0 or shndx == 0 or shndx >= len(self.sections):
+                continue
+            yield (self._str(strtab['offset'], name), info & 0xf, value, size, self.sections[shndx]['name'])
+
+
+def find_strings(data):
+    """Return the printable, NUL-terminated strings in data."""
+    return [m.group(1) for m in re.finditer(rb'([\x09\x0a\x0d\x20-\x7e]{%d,})\x00' % MIN_STRING_LENGTH, data)]
+
+
+def report(image, rom_size, elf, top):
+    used = len(image)
+    print('Application image: %d bytes of %d ( %.1f%% ), %d bytes free' % (used, rom_size, 100.0 * used / rom_size, rom_size - used))
+
+    rodata = image
+    if elf is not None:
+        print('\nSections:')
+        offset = 0
+        for name in IMAGE_SECTIONS + ('.bss',):
+            s = elf.section(name)
+            size = s['size'] if s else 0
+            print('  %-8s %6d bytes%s' % (name, size, '' if name in IMAGE_SECTIONS else ' ( RAM only )'))
+            if name == '.rodata':
+                rodata = image[offset:offset + size]
+            if name in IMAGE_SECTIONS:
+                offset += size
+
+        elf_image = b''.join(elf.contents(name) for name in IMAGE_SECTIONS)
+        if elf_image.rstrip(b'\0') != image.rstrip(b'\0'):
+            print('\nWARNING: ELF file does not match the VHDL image. Run "make install" to regenerate the image.')
+
+        syms = sorted((s for s in elf.symbols() if s[1] in (Elf32.STT_FUNC, Elf32.STT_OBJECT) and s[4] in IMAGE_SECTIONS),
+                      key=lambda s: -s[3])
+        if top > 0:
+            syms = syms[:top]
+        print('\nLargest functions and objects:')
+        for name, stype, addr, size, section in syms:
+            print('  %6d  0x%04x  %-8s %s' % (size, addr, section, name))
+
+        helpers = sorted((s[0], s[3]) for s in elf.symbols() if HELPER_RE.match(s[0]) and s[4] in IMAGE_SECTIONS)
+        print('\nArithmetic helpers: %d bytes' % sum(size for name, size in helpers))
+        for name, size in helpers:
+            print('  %6d  %s%s' % (size, name, '  ( 64-bit )' if HELPER_64_RE.match(name) else ''))
+
+    strings = find_strings(rodata)
+    print('\nString table: %d strings, %d bytes%s' % (len(strings), sum(len(s) + 1 for s in strings),
+                                                      '' if elf is not None else ' ( whole image scanned )'))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('image', help='neo430_application_image_*.vhd')
+    parser.add_argument('--elf', help='ELF file from the same build ( main.elf )')
+    parser.add_argument('--linker-script', default=DEFAULT_LINKER_SCRIPT, help='linker script giving the ROM size')
+    parser.add_argument('--rom-size', type=lambda x: int(x, 0), help='ROM size in bytes ( overrides the linker script )')
+    parser.add_argument('--min-headroom', type=lambda x: int(x, 0), default=0, help='fail if fewer bytes are free')
+    parser.add_argument('--top', type=int, default=20, help='number of functions to list ( 0 = all )')
+    parser.add_argument('--raw', action='store_true', help='write the binary image to stdout and exit')
+    parser.add_argument('--write-stamp', action='store_true', help='record the image and its sources ( make install ) and exit')
+    parser.add_argument('--check-stamp', action='store_true', help='fail if the sources changed since the image was built')
+    args = parser.parse_args()
+
+    if args.write_stamp:
+        write_stamp(args.image)
+        return 0
+
+    image = read_image(args.image)
+
+    if args.raw:
+        sys.stdout.buffer.write(image)
+        return 0
+
+    rom_size = args.rom_size
+    if rom_size is None and os.path.exists(args.linker_script):
+        rom_size = read_rom_size(args.linker_script)
+    if rom_size is None:
+        rom_size = DEFAULT_ROM_SIZE
 
-# Read in lines
-with open(from_file) as in_file:
-    lines = in_file.read().splitlines()
+    elf = Elf32(args.elf) if args.elf else None
 
-for i in lines:
-    #print i
-    m = re.search('x"([0-9a-f]+)"', i)
-    if (m):
-        numberStr = m.group(0)
-        number = numberStr[2:6]
-        # print number
+    report(image, rom_size, elf, args.top)
 
-        converted = int( number , 16)
-        convertedLow = chr(converted & 0x00FF)
-        convertedHigh = chr((converted >> 8) & 0xFF)
-        # print "high, low = ", convertedLow , convertedHigh
+    status = 0
+    headroom = rom_size - len(image)
+    if headroom < args.min_headroom:
+        print('\nERROR: only %d bytes free, %d required' % (headroom, args.min_headroom))
+        status = 1
 
-        sys.stdout.write(convertedLow + convertedHigh)
-        #this to print the result for reference on-screen.
-        #print "converted =" + str(converted)
+    if args.check_stamp:
+        diff = check_stamp(args.image)
+        if diff:
+            print('\nERROR: the image is not built from the sources on disk. Run "make install" and commit both:')
+            print('\n'.join('  ' + line for line in diff))
+            status = 1
+    return status
 
-#print "done."
 
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------------------
+#
+#   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+#
+#                                     - - -
+#
+#   Additional information about ipbus-firmare and the list of ipbus-firmware
+#   contacts are available at
+#
+#       https://ipbus.web.cern.ch/ipbus
+#
+#-------------------------------------------------------------------------------
+
+
+# Runs the ctr_slaves and ram_slaves test scripts, and a throughput benchmark,
+# against ipbus_udp_emulator.py instead of a simulation. No firmware tools needed.
+
+SH_SOURCE=${BASH_SOURCE}
+IPBUS_PATH=$(cd $(dirname ${SH_SOURCE})/../.. && pwd)
+EMU_PATH=${IPBUS_PATH}/tests/emulator/scripts
+PORT=${1:-50001}
+
+# Stop on the first error
+set -e
+# set -x
+
+EMU_PID=
+function cleanup {
+  [ -n "${EMU_PID}" ] && kill ${EMU_PID} 2>/dev/null || true
+}
+trap cleanup EXIT
+
+function start_emulator {
+  cleanup
+  python3 ${EMU_PATH}/ipbus_udp_emulator.py ${1} --port ${PORT} &
+  EMU_PID=$!
+  python3 ${EMU_PATH}/ipbus_udp_benchmark.py localhost:${PORT} probe --timeout 10
+}
+
+set -x
+python3 -m pytest -x -v ${EMU_PATH}/test_ipbus_udp_emulator.py
+
+CTR_ADDR=${IPBUS_PATH}/tests/ctr_slaves/addr_table/ctr_slaves_tester.xml
+start_emulator ${CTR_ADDR}
+pytest -x -v ${IPBUS_PATH}/tests/ctr_slaves/scripts/test_ctr_slaves.py --client ipbusudp-2.0://localhost:${PORT} --addr file://${CTR_ADDR}
+python3 ${EMU_PATH}/ipbus_udp_benchmark.py localhost:${PORT} read 0x1 --trans 16 --seconds 2
+
+RAM_ADDR=${IPBUS_PATH}/tests/ram_slaves/addr_table/ram_slaves_tester.xml
+start_emulator ${RAM_ADDR}
+python3 ${IPBUS_PATH}/tests/ram_slaves/software/test-ram-tests.py --client ipbusudp-2.0://localhost:${PORT} --addr file://${RAM_ADDR} --wait 0
+python3 ${EMU_PATH}/ipbus_udp_benchmark.py localhost:${PORT} read 0x1000 --words 255 --seconds 2
+python3 ${EMU_PATH}/ipbus_udp_benchmark.py localhost:${PORT} write 0x2000 --words 255 --seconds 2
+set +x
+
+exit 0
@@ -0,0 +1,53 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------------------
+#
+#   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+#
+#                                     - - -
+#
+#   Additional information about ipbus-firmare and the list of ipbus-firmware
+#   contacts are available at
+#
+#       https://ipbus.web.cern.ch/ipbus
+#
+#-------------------------------------------------------------------------------
+
+
+# Builds and runs the ram_slaves, ctr_slaves, neo430_wrapper and ipbus_arb
+# testbenches with GHDL, in parallel ( see tests/ghdl/scripts/run_ghdl_regression.py ).
+# Extra arguments go to the runner, e.g. -k neo430 or -j 4
+# Needs ghdl on the PATH. Run in CI on the ghdl/ghdl image ( run_ghdl_regression in ci/sim.yml ),
+# without the udp tests, which need uHAL.
+
+SH_SOURCE=${BASH_SOURCE}
+IPBUS_PATH=$(cd $(dirname ${SH_SOURCE})/../.. && pwd)
+WORK_ROOT=$(cd ${IPBUS_PATH}/../.. && pwd)
+PROJ=ghdl_regression
+
+# Stop on the first error
+set -e
+# set -x
+
+cd ${WORK_ROOT}
+rm -rf proj/${PROJ}
+mkdir -p proj/${PROJ}
+cd proj/${PROJ}
+
+set -x
+python3 ${IPBUS_PATH}/tests/ghdl/scripts/run_ghdl_regression.py --src ${WORK_ROOT}/src --work . \
+  --junit ${WORK_ROOT}/ghdl_regression.xml --metrics ${WORK_ROOT}/ghdl_regression_metrics.txt "$@"
+set +x
+
+exit 0
@@ -0,0 +1,58 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------------------
+#
+#   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+#
+#                                     - - -
+#
+#   Additional information about ipbus-firmare and the list of ipbus-firmware
+#   contacts are available at
+#
+#       https://ipbus.web.cern.ch/ipbus
+#
+#-------------------------------------------------------------------------------
+
+
+SH_SOURCE=${BASH_SOURCE}
+IPBUS_PATH=$(cd $(dirname ${SH_SOURCE})/../.. && pwd)
+WORK_ROOT=$(cd ${IPBUS_PATH}/../.. && pwd)
+PROJ=sim_i2c_trace
+
+# Stop on the first error
+set -e
+# set -x
+
+cd ${WORK_ROOT}
+rm -rf proj/${PROJ}
+
+ipbb proj create sim -t top_sim.dep ${PROJ} ipbus-firmware:tests/i2c_trace
+cd proj/${PROJ}
+
+ipbb sim setup-simlib
+ipbb sim ipcores
+ipbb sim make-project
+
+set -x
+./vsim -c work.top -do 'run -all' -do 'quit' | tee vsim.log
+set +x
+
+# The testbench reports wrong events and registers with severity error
+if grep -q "^# \*\* Error" vsim.log; then
+    echo "I2C trace test failed"
+    exit 1
+fi
+
+grep -E "I2C trace" vsim.log
+exit 0
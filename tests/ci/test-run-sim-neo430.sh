@@ -0,0 +1,87 @@
+#!/usr/bin/env bash
+#-------------------------------------------------------------------------------
+#
+#   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+#
+#                                     - - -
+#
+#   Additional information about ipbus-firmare and the list of ipbus-firmware
+#   contacts are available at
+#
+#       https://ipbus.web.cern.ch/ipbus
+#
+#-------------------------------------------------------------------------------
+
+
+SH_SOURCE=${BASH_SOURCE}
+IPBUS_PATH=$(cd $(dirname ${SH_SOURCE})/../.. && pwd)
+WORK_ROOT=$(cd ${IPBUS_PATH}/../.. && pwd)
+PROJ=sim_neo430_wrapper
+# The times reported by each scenario, kept as a CI artifact
+SUMMARY=${WORK_ROOT}/neo430_boot_times.txt
+
+# Stop on the first error
+set -e
+# set -x
+
+# The scenarios boot the committed image: make sure it is built from the sources on disk
+python3 ${IPBUS_PATH}/components/neo430_wrapper/software/neo430_ipbus_address_terminal/decode_neo430_application_image.py \
+  ${IPBUS_PATH}/components/neo430_wrapper/firmware/hdl/neo430_application_image_macprom.vhd --check-stamp
+
+cd ${WORK_ROOT}
+rm -rf proj/${PROJ} ${SUMMARY}
+
+ipbb proj create sim -t top_sim.dep ${PROJ} ipbus-firmware:tests/neo430_wrapper
+cd proj/${PROJ}
+
+ipbb sim setup-simlib
+ipbb sim ipcores
+ipbb sim make-project
+
+# Run one boot scenario: name, then extra vsim arguments ( generics )
+function run_scenario() {
+    local NAME=$1
+    shift
+    echo "Boot scenario: ${NAME}"
+    set -x
+    ./vsim -c work.top "$@" -do 'run -all' -do 'quit' | tee vsim_${NAME}.log
+    set +x
+
+    # The testbench reports wrong addresses with severity error
+    if grep -qE "^# \*\* (Error|Failure)" vsim_${NAME}.log; then
+        echo "NEO430 wrapper boot test failed: ${NAME}"
+        exit 1
+    fi
+
+    echo "${NAME}: $*" >> ${SUMMARY}
+    grep -E "set at|released at|Boot to link|first reply" vsim_${NAME}.log | tee -a ${SUMMARY}
+}
+
+run_scenario prom
+# The same boot with the CPU on the 125MHz clock, to compare the boot to link time
+run_scenario clk125 -gCLOCK_SPEED=125000000
+# Time from the IPBus reset release to the first IPBus reply through ipbus_ctrl, with a fixed IP address and
+# with RARP: a quick RARP server, a slow one, and one losing the first two requests
+run_scenario link_static -gIPBUS_LINK=true
+run_scenario link_rarp -gIPBUS_LINK=true -gPROM_RARP=true
+run_scenario link_rarp_slow -gIPBUS_LINK=true -gPROM_RARP=true -gRARP_DELAY_US=20000
+run_scenario link_rarp_loss -gIPBUS_LINK=true -gPROM_RARP=true -gRARP_PATTERN=DDR
+
+cat ${SUMMARY}
+
+# Fail if a scenario got slower than its reference time ( tests/neo430_wrapper/boot_times.ref )
+python3 ${IPBUS_PATH}/tests/neo430_wrapper/scripts/check_boot_times.py ${SUMMARY}
+
+exit 0
@@ -51,8 +51,8 @@ set -x
 VSIM_PID=$!
 VSIM_PGRP=$(ps -p ${VSIM_PID} -o pgrp=)
 
-# wait for the simulation to start
-sleep 10
+# wait for the simulation to answer, rather than for a fixed time
+python3 ${IPBUS_PATH}/tests/emulator/scripts/ipbus_udp_benchmark.py localhost:50001 probe --timeout 120
 
 # Run the test script
 pytest -x -v ${IPBUS_PATH}/tests/ctr_slaves/scripts/test_ctr_slaves.py --client ipbusudp-2.0://localhost:50001 --addr file://addrtab/ctr_slaves_tester.xml
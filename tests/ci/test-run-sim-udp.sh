@@ -67,8 +67,8 @@ if [[ "$PROJ" == "sim" ]]; then
   ./vsim -c work.top -do 'run 60sec' -do 'quit' > /dev/null 2>&1 &
   VSIM_PID=$!
   VSIM_PGRP=$(ps -p ${VSIM_PID} -o pgrp=)
-  # Wait for the simulation to start
-  sleep 10
+  # Wait for the simulation to answer, rather than for a fixed time
+  python3 ${IPBUS_PATH}/tests/emulator/scripts/ipbus_udp_benchmark.py localhost:50001 probe --timeout 120
   # Run very brief soak test
   PerfTester.exe -d ipbusudp-2.0://localhost:50001 -t Validation -i 1 -b 0x1000 -w 512
   # Cleanup, send SIGINT to the vsimk process in the current process group
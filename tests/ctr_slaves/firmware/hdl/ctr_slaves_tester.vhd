@@ -28,6 +28,8 @@
 --
 -- Test entity for the validation of ipbus counter slaves.
 -- Control register block gives the ability to increment / decrement specific counter blocks
+-- Snapshot block copies the wide counter blocks into a shadow bank on a single strobe,
+-- so that all channels can be read back coherently in one block read
 
 
 library ieee;
@@ -58,6 +60,9 @@ architecture rtl of ctr_slaves_tester is
 	type incdec_t is array(15 downto 0) of std_logic_vector(15 downto 0);
 
 	constant LARGE_BLOCK_SIZE : positive := 5;
+	constant WIDE_CTR_WDS : positive := 2;
+	constant N_SNAP_BLOCKS : positive := 4;
+	constant N_SNAP_WDS : positive := N_SNAP_BLOCKS * LARGE_BLOCK_SIZE * WIDE_CTR_WDS;
 
 	signal ipbw: ipb_wbus_array(N_SLAVES - 1 downto 0);
 	signal ipbr: ipb_rbus_array(N_SLAVES - 1 downto 0);
@@ -74,6 +79,11 @@ architecture rtl of ctr_slaves_tester is
 
 	signal tester_active: std_logic := '0';
 
+	signal snap_ctrl: ipb_reg_v(0 downto 0);
+	signal snap_stb_v: std_logic_vector(0 downto 0);
+	signal snap_stb: std_logic;
+	signal snap_live, snap_shadow: ipb_reg_v(N_SNAP_WDS - 1 downto 0);
+
 begin
 
 -- ipbus address decode
@@ -193,6 +203,39 @@ begin
 	end generate gen_incr_slave;
 
 
+-- Snapshot: latch the wide counter blocks into a shadow bank on the same clock edge
+
+	snapshot: entity work.ipbus_syncreg_v
+		generic map(
+			N_CTRL => 1,
+			N_STAT => N_SNAP_WDS
+			)
+		port map(
+			clk => ipb_clk,
+			rst => ipb_rst,
+			ipb_in => ipbw(N_SLV_SNAPSHOT),
+			ipb_out => ipbr(N_SLV_SNAPSHOT),
+			slv_clk => clk,
+			d => snap_shadow,
+			q => snap_ctrl,
+			stb => snap_stb_v,
+			rstb => open
+		);
+
+	snap_stb <= snap_ctrl(0)(0) and snap_stb_v(0);
+
+	process (clk)
+	begin
+		if rising_edge(clk) then
+			if rst = '1' then
+				snap_shadow <= (others => (others => '0'));
+			elsif snap_stb = '1' then
+				snap_shadow <= snap_live;
+			end if;
+		end if;
+	end process;
+
+
 
 -- Counter block slave 1: Small
 
@@ -263,7 +306,7 @@ begin
 			rst => rst,
 			inc => increment(3)(4 downto 0),
 			dec => decrement(3)(4 downto 0),
-			q => open
+			q => snap_live(9 downto 0)
 		);
 
 -- Counter block slave 5: Several counters, each 2 words, wraps around
@@ -303,7 +346,7 @@ begin
 			rst => rst,
 			inc => increment(5)(4 downto 0),
 			dec => decrement(5)(4 downto 0),
-			q => open
+			q => snap_live(19 downto 10)
 		);
 
 -- Counter block slave 7: Several counters, each 2 words, resets on read, read-write
@@ -399,7 +442,7 @@ begin
 			rst => rst,
 			inc => increment(11)(4 downto 0),
 			dec => decrement(11)(4 downto 0),
-			q => open
+			q => snap_live(29 downto 20)
 		);
 
 -- Ported counter slave 5: Several counters, each 2 words, wraps around
@@ -439,7 +482,7 @@ begin
 			rst => rst,
 			inc => increment(13)(4 downto 0),
 			dec => decrement(13)(4 downto 0),
-			q => open
+			q => snap_live(39 downto 30)
 		);
 
 -- Ported counter slave 7: Several counters, each 2 words, resets on read, read-write
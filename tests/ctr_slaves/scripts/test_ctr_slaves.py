@@ -374,3 +374,78 @@ def test_slave_counter(hw, node_id, idx, ported, params):
     ctrl = Controller(hw.getNode('testctrl'), ctr_node, idx, ported=ported, **params)
 
     ctrl.run_tests(hw.getNode('csr.ctrl'))
+
+
+# Slaves mirrored in the snapshot shadow bank, in bank order
+SNAPSHOT_SLAVES = [
+    (3,  'ctrs.block.large_wide',           False, {'num':5, 'width':2}),
+    (5,  'ctrs.block.large_wide_readreset', False, {'num':5, 'width':2, 'reset_on_read':True}),
+    (11, 'ctrs.ported.large_wide',          True,  {'num':5, 'width':2}),
+    (13, 'ctrs.ported.large_wide_readreset',True,  {'num':5, 'width':2, 'reset_on_read':True}),
+    ]
+
+
+def read_snapshot(snapshot_node, latch=True):
+    if latch:
+        snapshot_node.getNode('ctrl.latch').write(1)
+    xx = snapshot_node.getNode('ctrs').readBlock(snapshot_node.getNode('ctrs').getSize())
+    snapshot_node.getClient().dispatch()
+
+    values = []
+    for (_, _, _, params) in SNAPSHOT_SLAVES:
+        for i in range(params['num']):
+            values.append(sum([xx[len(values) * params['width'] + j] * (2 ** (32*j)) for j in range(params['width'])]))
+    return values
+
+
+def test_snapshot(hw):
+
+    csr_node = hw.getNode('csr.ctrl')
+    snapshot_node = hw.getNode('snapshot')
+    ctrls = [Controller(hw.getNode('testctrl'), hw.getNode(node_id), idx, ported=ported, **params) for (idx, node_id, ported, params) in SNAPSHOT_SLAVES]
+
+    # PART A: Shadow bank follows the counters only when latched
+    reset(csr_node)
+    assert read_snapshot(snapshot_node) == [0] * 20
+
+    for k, ctrl in enumerate(ctrls):
+        for i in range(5):
+            ctrl.increment(2 ** i, 1 + i + 7 * k)
+
+    expected = sum([list(ctrl._values_current) for ctrl in ctrls], [])
+    assert read_snapshot(snapshot_node, latch=False) == [0] * 20
+    assert read_snapshot(snapshot_node) == expected
+    # Reading the shadow bank must not reset the read-reset counters
+    assert read_snapshot(snapshot_node) == expected
+    for ctrl in ctrls:
+        ctrl.check_values()
+
+    # PART B: Latch while every channel of every mirrored slave increments in lock-step;
+    # a coherent snapshot has all 20 counters equal
+    reset(csr_node)
+    testctrl_node = hw.getNode('testctrl')
+    testctrl_node.getNode('mask.channel').write(0x1f)
+    testctrl_node.getNode('mask.slave').write(sum([2 ** idx for (idx, _, _, _) in SNAPSHOT_SLAVES]))
+    testctrl_node.getNode('action.type').write(1)
+    testctrl_node.getNode('action.wait').write(7)
+    testctrl_node.getNode('action.count').write(0x10000)
+    testctrl_node.getNode('start').write(1)
+    testctrl_node.getClient().dispatch()
+    testctrl_node.getNode('start').write(0)
+    testctrl_node.getClient().dispatch()
+
+    last = 0
+    for n in range(50):
+        values = read_snapshot(snapshot_node)
+        assert len(set(values)) == 1, "Snapshot {} is not coherent: {}".format(n, values)
+        assert values[0] >= last
+        last = values[0]
+
+    while True:
+        active = testctrl_node.getNode('active').read()
+        testctrl_node.getClient().dispatch()
+        if not active:
+            break
+        time.sleep(1)
+
+    assert read_snapshot(snapshot_node) == [0x10000] * 20
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+Throughput and latency benchmark for an IPbus 2.0 UDP endpoint ( a board, a
+simulation or ipbus_udp_emulator.py ), with a minimal client that needs no uHAL.
+
+e.g.
+  python3 ipbus_udp_benchmark.py localhost:50001 probe --timeout 10
+  python3 ipbus_udp_benchmark.py localhost:50001 read 0x1000 --words 255 --window 8 --seconds 5
+  python3 ipbus_udp_benchmark.py 192.168.201.2:50001 write 0x1000 --trans 16 --words 1
+
+probe waits until the endpoint answers a status request ( exit code 0 ), so
+scripts can use it instead of sleeping while a simulation starts.
+
+read / write send control packets of --trans transactions of --words words to
+( incrementing from ) the address, keeping --window packets in flight, and
+print packets, transactions and payload per second and the round-trip times.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+
+class IPbusError(Exception):
+    pass
+
+
+class Client:
+    """IPbus 2.0 over UDP, big endian, with packet IDs."""
+
+    def __init__(self, host, port, timeout=1.0):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(timeout)
+        self.sock.connect((host, port))
+        self.next_id = None
+        self.trans_id = 0
+
+    def status(self):
+        """Return ( MTU, response buffers, next expected packet ID )."""
+        self.sock.send(struct.pack('>16I', 0x200000f1, *([0] * 15)))
+        rsp = struct.unpack('>16I', self.sock.recv(65536)[:64])
+        if rsp[0] != 0x200000f1:
+            raise IPbusError('bad status response header 0x%08x' % rsp[0])
+        self.next_id = (rsp[3] >> 8) & 0xffff
+        return rsp[1], rsp[2], self.next_id
+
+    def packet(self, transactions):
+        """Encode a control packet of ( type, address, write data or number of words ) transactions."""
+        if self.next_id is None:
+            self.status()
+        words = [0x200000f0 | (self.next_id << 8)]
+        self.next_id = self.next_id % 0xffff + 1
+        for trans_type, addr, data in transactions:
+            n = data if isinstance(data, int) else len(data)
+            words.append(0x2000000f | (self.trans_id << 16) | (n << 8) | (trans_type << 4))
+            words.append(addr)
+            if not isinstance(data, int):
+                words.extend(data)
+            self.trans_id = (self.trans_id + 1) & 0xfff
+        return struct.pack('>%dI' % len(words), *words)
+
+    @staticmethod
+    def decode(data):
+        """Return [ ( type, info code, read words ) ] of a control response."""
+        words = struct.unpack('>%dI' % (len(data) // 4), data)
+        result = []
+        i = 1
+        while i < len(words):
+            n = (words[i] >> 8) & 0xff
+            trans_type = (words[i] >> 4) & 0xf
+            info = words[i] & 0xf
+            read = trans_type in (0, 2, 4, 5) and info == 0
+            result.append((trans_type, info, list(words[i + 1:i + 1 + n]) if read else []))
+            i += 1 + (n if read else 0)
+        return result
+
+    def transact(self, transactions):
+        self.sock.send(self.packet(transactions))
+        result = self.decode(self.sock.recv(65536))
+        for trans_type, info, data in result:
+            if info:
+                raise IPbusError('transaction type %d failed, info code 0x%x' % (trans_type, info))
+        if len(result) != len(transactions):
+            raise IPbusError('%d transactions sent, %d answered' % (len(transactions), len(result)))
+        return [data for trans_type, info, data in result]
+
+    def read(self, addr, n=1, incr=True):
+        return self.transact([(0 if incr else 2, addr, n)])[0]
+
+    def write(self, addr, data, incr=True):
+        self.transact([(1 if incr else 3, addr, list(data))])
+
+    def rmw_bits(self, addr, and_term, or_term):
+        return self.transact([(4, addr, [and_term, or_term])])[0][0]
+
+    def rmw_sum(self, addr, addend):
+        return self.transact([(5, addr, [addend])])[0][0]
+
+
+def probe(host, port, timeout):
+    t_end = time.monotonic() + timeout
+    while True:
+        try:
+            mtu, buffers, next_id = Client(host, port, 0.2).status()
+            print('%s:%d up: MTU %d, %d buffers, next packet ID %d' % (host, port, mtu, buffers, next_id))
+            return 0
+        except (OSError, IPbusError, struct.error):
+            if time.monotonic() > t_end:
+                print('ERROR: no answer from %s:%d after %g s' % (host, port, timeout))
+                return 1
+            time.sleep(0.2)
+
+
+def benchmark(client, write, addr, n_trans, n_words, window, seconds):
+    if write:
+        trans = [(1, addr, list(range(n_words)))] * n_trans
+    else:
+        trans = [(0, addr, n_words)] * n_trans
+
+    client.status()
+    sent = {}
+    rtts = []
+    t_start = time.monotonic()
+    t_end = t_start + seconds
+    while True:
+        now = time.monotonic()
+        while len(sent) < window and now < t_end:
+            pkt = client.packet(trans)
+            client.sock.send(pkt)
+            sent[pkt[1:3]] = now
+        if not sent:
+            break
+        rsp = client.sock.recv(65536)
+        rtts.append(time.monotonic() - sent.pop(rsp[1:3]))
+        for trans_type, info, data in client.decode(rsp):
+            if info:
+                raise IPbusError('transaction failed, info code 0x%x' % info)
+    elapsed = time.monotonic() - t_start
+
+    rtts.sort()
+    n_pkts = len(rtts)
+    print('%d packets in %.2f s: %.0f packets/s, %.0f transactions/s, %.2f Mbit/s %s' % (
+        n_pkts, elapsed, n_pkts / elapsed, n_pkts * n_trans / elapsed,
+        n_pkts * n_trans * n_words * 32 / elapsed / 1e6, 'written' if write else 'read'))
+    print('round trip: median %.0f us, 99%% %.0f us, max %.0f us' % (
+        rtts[n_pkts // 2] * 1e6, rtts[int(n_pkts * 0.99)] * 1e6, rtts[-1] * 1e6))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('target', help='host:port')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+    p = sub.add_parser('probe', help='wait for the endpoint to answer')
+    p.add_argument('--timeout', type=float, default=30.0)
+    for cmd in ('read', 'write'):
+        p = sub.add_parser(cmd)
+        p.add_argument('addr', type=lambda s: int(s, 0))
+        p.add_argument('--trans', type=int, default=1, help='transactions per packet')
+        p.add_argument('--words', type=int, default=1, help='words per transaction ( up to 255 )')
+        p.add_argument('--window', type=int, default=4, help='packets in flight')
+        p.add_argument('--seconds', type=float, default=2.0)
+    args = parser.parse_args()
+
+    host, _, port = args.target.rpartition(':')
+    if args.cmd == 'probe':
+        return probe(host, int(port), args.timeout)
+
+    try:
+        benchmark(Client(host, int(port)), args.cmd == 'write', args.addr, args.trans, args.words,
+                  args.window, args.seconds)
+    except (OSError, IPbusError) as e:
+        print('ERROR: %s' % e)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
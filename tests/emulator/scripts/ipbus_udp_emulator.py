@@ -0,0 +1,667 @@
+#!/usr/bin/env python3
+"""
+Software IPbus 2.0 UDP endpoint emulating the ram_slaves and ctr_slaves
+test designs, so that their Python test suites ( and benchmarks ) run in
+seconds without hardware or a vsim simulation.
+
+e.g.
+  python3 ipbus_udp_emulator.py ../../ctr_slaves/addr_table/ctr_slaves_tester.xml
+  pytest -x ../../ctr_slaves/scripts/test_ctr_slaves.py --client ipbusudp-2.0://localhost:50001 \\
+      --addr file://../../ctr_slaves/addr_table/ctr_slaves_tester.xml
+
+Endpoint addresses come from the address table; what each endpoint does comes
+from the tables below, which mirror the generics in ram_slaves_tester.vhd and
+ctr_slaves_tester.vhd ( the design is picked from the address table file name,
+or --design ):
+
+  ipbus_ctrlreg_v / ipbus_syncreg_v  control registers in the lower half of the
+                                     endpoint, status in the upper half
+  ipbus_reg_v                        read / write register
+  ipbus_ram, ipbus_dpram*            block RAMs; 36 and 72 bit words take 2 and
+  ipbus_sdpram72                     4 IPbus words, upper bits masked. sdpram72
+                                     is read only from IPbus
+  ipbus_peephole_ram,                address register at 0, data port at 1,
+  ipbus_ported_*                     address incremented on every data access
+  ram_pattern_generator              fills the dual port RAMs when fired
+  ipbus_ctrs_v, ipbus_ctrs_ported    counters, sampled when word 0 is read ( and
+                                     reset then, if RST_ON_READ ). Saturating or
+                                     wrapping; writeable ones load all counters
+                                     when the last reference word is written
+  testctrl                           increment / decrement engine, advanced in
+                                     time at --clk-mhz
+  snapshot                           shadow copy of the wide counters, latched
+                                     by writing ctrl.latch
+
+csr.ctrl.rst resets the counters, the test engine and the snapshot, as
+soft_rst does. Unmapped addresses give bus errors.
+
+Protocol: IPbus 2.0 control, status and re-send packets, either byte order.
+Control packets must carry the next expected packet ID ( or 0 ); others are
+dropped, as by the firmware, and the last --buffers responses can be re-sent.
+"""
+
+import argparse
+import bisect
+import os
+import socket
+import struct
+import sys
+import time
+import xml.etree.ElementTree as ET
+
+PROTOCOL_VERSION = 2
+
+PKT_CONTROL = 0x0
+PKT_STATUS = 0x1
+PKT_RESEND = 0x2
+
+TRANS_READ = 0x0
+TRANS_WRITE = 0x1
+TRANS_NI_READ = 0x2
+TRANS_NI_WRITE = 0x3
+TRANS_RMW_BITS = 0x4
+TRANS_RMW_SUM = 0x5
+
+INFO_OK = 0x0
+INFO_BAD_HEADER = 0x1
+INFO_READ_ERROR = 0x4
+INFO_WRITE_ERROR = 0x5
+INFO_REQUEST = 0xf
+
+MASK32 = 0xffffffff
+
+
+class BusError(Exception):
+    pass
+
+
+# ---------------------------------------------------------------------------
+# Slave models. offset is the word address within the endpoint.
+# ---------------------------------------------------------------------------
+
+class Slave:
+    size = 1
+
+    def read(self, offset):
+        raise BusError()
+
+    def write(self, offset, value):
+        raise BusError()
+
+    def read_block(self, offset, n, incr):
+        return [self.read(offset + i if incr else offset) for i in range(n)]
+
+    def write_block(self, offset, values, incr):
+        for i, v in enumerate(values):
+            self.write(offset + i if incr else offset, v)
+
+
+class Reg(Slave):
+    """ipbus_reg_v with one register."""
+
+    def __init__(self):
+        self.value = 0
+
+    def read(self, offset):
+        return self.value
+
+    def write(self, offset, value):
+        self.value = value
+
+
+class CtrlStat(Slave):
+    """ipbus_ctrlreg_v / ipbus_syncreg_v: control registers from 0, status from half way."""
+
+    def __init__(self, size, n_ctrl, stat=lambda i: 0, on_write=None):
+        self.size = size
+        self.ctrl = [0] * n_ctrl
+        self._stat = stat
+        self._on_write = on_write
+
+    def read(self, offset):
+        if offset >= self.size // 2 and self.size > 1:
+            return self._stat(offset - self.size // 2) & MASK32
+        if offset < len(self.ctrl):
+            return self.ctrl[offset]
+        return 0
+
+    def write(self, offset, value):
+        if offset < len(self.ctrl) and (offset < self.size // 2 or self.size == 1):
+            previous = self.ctrl[offset]
+            self.ctrl[offset] = value
+            if self._on_write:
+                self._on_write(offset, value, previous)
+
+
+def word_masks(bits):
+    """Masks of the IPbus words holding one RAM word of this many bits ( 1, 2 or 4 words )."""
+    n = 1
+    while n * 32 < bits:
+        n *= 2
+    return [((1 << max(0, min(32, bits - 32 * i))) - 1) for i in range(n)]
+
+
+class Ram(Slave):
+    """Block RAM, depth RAM words of bits each."""
+
+    def __init__(self, depth, bits=32, writeable=True):
+        self.masks = word_masks(bits)
+        self.size = depth * len(self.masks)
+        self.words = [0] * self.size
+        self.writeable = writeable
+
+    def read(self, offset):
+        return self.words[offset]
+
+    def write(self, offset, value):
+        if self.writeable:
+            self.words[offset] = value & self.masks[offset % len(self.masks)]
+
+    def read_block(self, offset, n, incr):
+        if incr:
+            return self.words[offset:offset + n]
+        return [self.words[offset]] * n
+
+    def store(self, addr, value):
+        """Write a whole RAM word from the fabric side."""
+        base = addr * len(self.masks)
+        for i, mask in enumerate(self.masks):
+            self.words[base + i] = (value >> (32 * i)) & mask
+
+
+class PortedRam(Slave):
+    """ipbus_peephole_ram / ipbus_ported_*: address register at 0, data port at 1."""
+
+    size = 2
+
+    def __init__(self, depth, bits=32, writeable=True):
+        self.ram = Ram(depth, bits, writeable)
+        self.ptr = 0
+
+    def read(self, offset):
+        if offset == 0:
+            return self.ptr
+        value = self.ram.words[self.ptr]
+        self.ptr = (self.ptr + 1) % self.ram.size
+        return value
+
+    def write(self, offset, value):
+        if offset == 0:
+            self.ptr = value % self.ram.size
+        else:
+            self.ram.write(self.ptr, value)
+            self.ptr = (self.ptr + 1) % self.ram.size
+
+    def store(self, addr, value):
+        self.ram.store(addr, value)
+
+
+class PatternGenerator(CtrlStat):
+    """ram_pattern_generator: writing ctrl.fire fills the targets with the pattern of ctrl.mode."""
+
+    ADDR_WIDTH = 10
+    DATA_WIDTH = 72
+
+    def __init__(self, size, targets):
+        CtrlStat.__init__(self, size, 1, on_write=self._fire)
+        self.targets = targets
+
+    def _fire(self, offset, value, previous):
+        if not value & 0x1:
+            return
+        mode = (value >> 1) & 0x3
+        word = (value >> 24) & 0xff
+        for addr in range(2 ** self.ADDR_WIDTH):
+            if mode == 1:
+                q = int.from_bytes(bytes([word]) * (self.DATA_WIDTH // 8), 'little')
+            elif mode == 2:
+                q = sum((((i & 0x3) << 16) | addr) << (18 * i) for i in range(self.DATA_WIDTH // 18))
+            else:
+                q = addr
+            for t in self.targets:
+                t.store(addr, q)
+
+
+class Counters:
+    """State of ipbus_ctrs_v / ipbus_ctrs_ported: n counters of width words."""
+
+    def __init__(self, num=1, width=1, limit=True, rst_on_read=False, read_only=True):
+        self.num = num
+        self.width = width
+        self.limit = limit
+        self.rst_on_read = rst_on_read
+        self.read_only = read_only
+        self.max = (1 << (32 * width)) - 1
+        self.values = [0] * num
+        self.sampled = [0] * (num * width)
+        self.refs = [0] * (num * width)
+
+    def reset(self):
+        self.values = [0] * self.num
+
+    def add(self, channel_mask, count):
+        for i in range(self.num):
+            if channel_mask & (1 << i):
+                v = self.values[i] + count
+                if self.limit:
+                    v = min(max(v, 0), self.max)
+                self.values[i] = v & self.max
+
+    def sample_word(self, index):
+        if index == 0:
+            self.sampled = [(v >> (32 * j)) & MASK32 for v in self.values for j in range(self.width)]
+            if self.rst_on_read:
+                self.reset()
+        return self.sampled[index] if index < len(self.sampled) else 0
+
+    def write_ref(self, index, value):
+        if self.read_only or index >= len(self.refs):
+            return
+        self.refs[index] = value
+        if index == len(self.refs) - 1:
+            self.values = [sum(self.refs[i * self.width + j] << (32 * j) for j in range(self.width))
+                           for i in range(self.num)]
+
+    def live_words(self):
+        return [(v >> (32 * j)) & MASK32 for v in self.values for j in range(self.width)]
+
+
+class BlockCounters(Slave):
+    """ipbus_ctrs_v: counters from 0, or references from 0 and counters from half way if writeable."""
+
+    def __init__(self, size, ctrs):
+        self.size = size
+        self.ctrs = ctrs
+        self._base = 0 if ctrs.read_only else size // 2
+
+    def read(self, offset):
+        if offset >= self._base:
+            return self.ctrs.sample_word(offset - self._base)
+        return self.ctrs.refs[offset] if offset < len(self.ctrs.refs) else 0
+
+    def write(self, offset, value):
+        if offset < self._base:
+            self.ctrs.write_ref(offset, value)
+
+
+class PortedCounters(Slave):
+    """ipbus_ctrs_ported: address register at 0, counter ( or reference ) words at 1."""
+
+    size = 2
+
+    def __init__(self, ctrs):
+        self.ctrs = ctrs
+        self.ptr = 0
+
+    def read(self, offset):
+        if offset == 0:
+            return self.ptr
+        value = self.ctrs.sample_word(self.ptr)
+        self.ptr += 1
+        return value
+
+    def write(self, offset, value):
+        if offset == 0:
+            self.ptr = value
+        else:
+            self.ctrs.write_ref(self.ptr, value)
+            self.ptr += 1
+
+
+class CounterTester:
+    """testctrl engine of ctr_slaves_tester: count increments or decrements, one every wait + 1 clocks."""
+
+    def __init__(self, slaves, clk_hz, clock=time.monotonic):
+        self.slaves = slaves  # tester slave index -> Counters
+        self.clk_hz = clk_hz
+        self.clock = clock
+        self.active = False
+        self.regs = None
+
+    def start(self, regs):
+        if self.active:
+            return
+        self.advance()
+        self.active = True
+        self.t_start = self.clock()
+        self.done = 0
+        self.mask_channel = regs[0] & 0xffff
+        self.mask_slave = regs[0] >> 16
+        self.incr = bool(regs[1] & 0x80000000)
+        self.wait = (regs[1] >> 28) & 0x7
+        self.count = (regs[1] & 0xfffffff) or 0x10000000
+
+    def stop(self):
+        self.active = False
+
+    def advance(self):
+        if not self.active:
+            return
+        cycles = int((self.clock() - self.t_start) * self.clk_hz)
+        done = min(self.count, cycles // (self.wait + 1))
+        step = done - self.done
+        if step:
+            for idx, ctrs in self.slaves.items():
+                if self.mask_slave & (1 << idx):
+                    ctrs.add(self.mask_channel, step if self.incr else -step)
+            self.done = done
+        if done == self.count:
+            self.active = False
+
+
+# ---------------------------------------------------------------------------
+# Designs
+# ---------------------------------------------------------------------------
+
+def read_endpoints(fname):
+    """Return { path: ( address, size ) } of the endpoints ( fwinfo="endpoint;width=N" ) in an address table."""
+    endpoints = {}
+
+    def walk(node, path, base):
+        addr = base + int(node.get('address', '0'), 0)
+        node_id = node.get('id')
+        if node_id is not None:
+            path = path + [node_id]
+        fwinfo = node.get('fwinfo', '')
+        if fwinfo.startswith('endpoint'):
+            width = 0
+            for item in fwinfo.split(';')[1:]:
+                key, _, value = item.partition('=')
+                if key.strip() == 'width':
+                    width = int(value, 0)
+            endpoints['.'.join(path)] = (addr, 1 << width)
+        for child in node.findall('node'):
+            walk(child, path, addr)
+
+    walk(ET.parse(fname).getroot(), [], 0)
+    return endpoints
+
+
+MAGIC_STAT = 0xabcdfedc  # stat(0) of both testers
+
+
+def ram_slaves_design(endpoints, clk_hz):
+    """ram_slaves_tester.vhd"""
+    rams = {
+        'ported_ram': PortedRam(1024),
+        'ported_dpram': PortedRam(1024),
+        'ported_dpram36': PortedRam(1024, 36),
+        'ported_dpram72': PortedRam(1024, 72),
+        'ported_sdpram72': PortedRam(1024, 72, writeable=False),
+        'ram': Ram(1024),
+        'dpram': Ram(1024),
+        'dpram36': Ram(1024, 36),
+        'sdpram72': Ram(1024, 72, writeable=False),
+    }
+    patt_targets = [rams[k] for k in ('ported_dpram', 'ported_dpram36', 'ported_dpram72', 'ported_sdpram72',
+                                      'dpram', 'dpram36', 'sdpram72')]
+    slaves = dict(rams)
+    slaves['csr'] = CtrlStat(endpoints['csr'][1], 1, stat=lambda i: MAGIC_STAT)
+    slaves['patt_gen'] = PatternGenerator(endpoints['patt_gen'][1], patt_targets)
+    slaves['reg'] = Reg()
+    return slaves
+
+
+# ctr_slaves_tester.vhd: tester slave index and generics of each counter slave
+CTR_SLAVES = {
+    'ctrs.block.small':                    (0,  False, {}),
+    'ctrs.block.small_rw':                 (1,  False, {'read_only': False}),
+    'ctrs.block.large':                    (2,  False, {'num': 5}),
+    'ctrs.block.large_wide':               (3,  False, {'num': 5, 'width': 2}),
+    'ctrs.block.large_wide_wraps':         (4,  False, {'num': 5, 'width': 2, 'limit': False}),
+    'ctrs.block.large_wide_readreset':     (5,  False, {'num': 5, 'width': 2, 'rst_on_read': True}),
+    'ctrs.block.large_wide_readreset_rw':  (6,  False, {'num': 5, 'width': 2, 'rst_on_read': True, 'read_only': False}),
+    'ctrs.ported.small':                   (8,  True,  {}),
+    'ctrs.ported.small_rw':                (9,  True,  {'read_only': False}),
+    'ctrs.ported.large':                   (10, True,  {'num': 5}),
+    'ctrs.ported.large_wide':              (11, True,  {'num': 5, 'width': 2}),
+    'ctrs.ported.large_wide_wraps':        (12, True,  {'num': 5, 'width': 2, 'limit': False}),
+    'ctrs.ported.large_wide_readreset':    (13, True,  {'num': 5, 'width': 2, 'rst_on_read': True}),
+    'ctrs.ported.large_wide_readreset_rw': (14, True,  {'num': 5, 'width': 2, 'rst_on_read': True, 'read_only': False}),
+}
+
+# Counter slaves mirrored by the snapshot shadow bank, in order
+SNAPSHOT_SLAVES = [3, 5, 11, 13]
+
+
+def ctr_slaves_design(endpoints, clk_hz):
+    """ctr_slaves_tester.vhd"""
+    slaves = {}
+    ctrs = {}
+    for path, (idx, ported, generics) in CTR_SLAVES.items():
+        ctrs[idx] = Counters(**generics)
+        slaves[path] = PortedCounters(ctrs[idx]) if ported else BlockCounters(endpoints[path][1], ctrs[idx])
+
+    tester = CounterTester(ctrs, clk_hz)
+    shadow = [0] * sum(ctrs[i].num * ctrs[i].width for i in SNAPSHOT_SLAVES)
+
+    def testctrl_write(offset, value, previous):
+        if offset == 2 and value & 0x1 and not previous & 0x1:
+            tester.start(slaves['testctrl'].ctrl)
+
+    def snapshot_write(offset, value, previous):
+        if value & 0x1:
+            tester.advance()
+            shadow[:] = sum((ctrs[i].live_words() for i in SNAPSHOT_SLAVES), [])
+
+    def soft_reset(offset, value, previous):
+        if value & 0x1:
+            tester.stop()
+            for c in ctrs.values():
+                c.reset()
+            shadow[:] = [0] * len(shadow)
+
+    slaves['csr'] = CtrlStat(endpoints['csr'][1], 1, stat=lambda i: MAGIC_STAT, on_write=soft_reset)
+    slaves['testctrl'] = CtrlStat(endpoints['testctrl'][1], 3, stat=lambda i: int(tester.active) if i == 0 else 0,
+                                  on_write=testctrl_write)
+    slaves['snapshot'] = CtrlStat(endpoints['snapshot'][1], 1, stat=lambda i: shadow[i] if i < len(shadow) else 0,
+                                  on_write=snapshot_write)
+    return slaves, tester
+
+
+DESIGNS = {
+    'ram_slaves_tester': ram_slaves_design,
+    'ctr_slaves_tester': ctr_slaves_design,
+}
+
+
+class AddressMap:
+    """Decodes an IPbus address to ( slave, offset ), as ipbus_fabric_sel with the generated decoder."""
+
+    def __init__(self, endpoints, slaves):
+        missing = set(slaves) - set(endpoints)
+        if missing:
+            raise ValueError('endpoints not in the address table: %s' % ', '.join(sorted(missing)))
+        self._ranges = sorted((endpoints[path][0], endpoints[path][1], slave) for path, slave in slaves.items())
+        self._bases = [r[0] for r in self._ranges]
+
+    def decode(self, addr, n=1):
+        i = bisect.bisect_right(self._bases, addr) - 1
+        if i >= 0:
+            base, size, slave = self._ranges[i]
+            if addr + n <= base + size:
+                return slave, addr - base
+        raise BusError()
+
+
+# ---------------------------------------------------------------------------
+# IPbus 2.0
+# ---------------------------------------------------------------------------
+
+class Endpoint:
+    """Packet handling of the IPbus UDP endpoint ( ipbus_ctrl ), independent of the socket."""
+
+    MAX_WORDS = 255
+
+    def __init__(self, address_map, tick=None, mtu=1500, buffers=16):
+        self.map = address_map
+        self.tick = tick  # called before each control packet, to advance time-driven models
+        self.mtu = mtu
+        self.buffers = buffers
+        self.next_id = 1
+        self.sent = {}  # packet ID -> response, for re-send requests
+        self.stats = {'control': 0, 'status': 0, 'resend': 0, 'dropped': 0, 'transactions': 0}
+
+    def handle(self, data):
+        """Return the response to a request packet, or None if it is dropped."""
+        if len(data) < 4 or len(data) % 4:
+            return None
+        header = struct.unpack_from('>I', data)[0]
+        order = '>'
+        if (header >> 28) != PROTOCOL_VERSION or (header >> 4) & 0xf != 0xf:
+            header = struct.unpack_from('<I', data)[0]
+            order = '<'
+            if (header >> 28) != PROTOCOL_VERSION or (header >> 4) & 0xf != 0xf:
+                return None
+        words = list(struct.unpack('%s%dI' % (order, len(data) // 4), data))
+        pkt_type = header & 0xf
+        pkt_id = (header >> 8) & 0xffff
+
+        if pkt_type == PKT_STATUS:
+            self.stats['status'] += 1
+            rsp = [header, self.mtu, self.buffers, (PROTOCOL_VERSION << 28) | (self.next_id << 8) | 0xf0] + [0] * 12
+        elif pkt_type == PKT_RESEND:
+            self.stats['resend'] += 1
+            return self.sent.get(pkt_id)
+        elif pkt_type == PKT_CONTROL:
+            if pkt_id != 0 and pkt_id != self.next_id:
+                self.stats['dropped'] += 1
+                return None
+            self.stats['control'] += 1
+            if self.tick:
+                self.tick()
+            rsp = [header] + self.control(words, 1)
+        else:
+            return None
+
+        packed = struct.pack('%s%dI' % (order, len(rsp)), *rsp)
+        if pkt_type == PKT_CONTROL and pkt_id != 0:
+            self.sent[pkt_id] = packed
+            self.sent.pop((pkt_id - self.buffers - 1) % 0xffff + 1, None)
+            self.next_id = pkt_id % 0xffff + 1
+        return packed
+
+    def control(self, words, i):
+        """Carry out the transactions from words[i], return the response words."""
+        rsp = []
+        while i < len(words):
+            header = words[i]
+            n = (header >> 8) & 0xff
+            trans_type = (header >> 4) & 0xf
+            if (header >> 28) != PROTOCOL_VERSION or header & 0xf != INFO_REQUEST or i + 1 >= len(words):
+                rsp.append((header & ~0xf) | INFO_BAD_HEADER)
+                break
+            addr = words[i + 1]
+            head = header & ~0xff0f  # words and info code filled in below
+            self.stats['transactions'] += 1
+
+            if trans_type in (TRANS_READ, TRANS_NI_READ):
+                incr = trans_type == TRANS_READ
+                try:
+                    slave, offset = self.map.decode(addr, n if incr else 1)
+                    data = slave.read_block(offset, n, incr)
+                except BusError:
+                    rsp.append(head | INFO_READ_ERROR)
+                    break
+                rsp.append(head | (n << 8) | INFO_OK)
+                rsp.extend(data)
+                i += 2
+
+            elif trans_type in (TRANS_WRITE, TRANS_NI_WRITE):
+                incr = trans_type == TRANS_WRITE
+                data = words[i + 2:i + 2 + n]
+                if len(data) < n:
+                    rsp.append((header & ~0xf) | INFO_BAD_HEADER)
+                    break
+                try:
+                    slave, offset = self.map.decode(addr, n if incr else 1)
+                    slave.write_block(offset, data, incr)
+                except BusError:
+                    rsp.append(head | INFO_WRITE_ERROR)
+                    break
+                rsp.append(head | (n << 8) | INFO_OK)
+                i += 2 + n
+
+            elif trans_type in (TRANS_RMW_BITS, TRANS_RMW_SUM):
+                n_args = 2 if trans_type == TRANS_RMW_BITS else 1
+                args = words[i + 2:i + 2 + n_args]
+                if len(args) < n_args:
+                    rsp.append((header & ~0xf) | INFO_BAD_HEADER)
+                    break
+                try:
+                    slave, offset = self.map.decode(addr)
+                    value = slave.read(offset)
+                    if trans_type == TRANS_RMW_BITS:
+                        slave.write(offset, (value & args[0]) | args[1])
+                    else:
+                        slave.write(offset, (value + args[0]) & MASK32)
+                except BusError:
+                    rsp.append(head | INFO_READ_ERROR)
+                    break
+                rsp.append(head | (1 << 8) | INFO_OK)
+                rsp.append(value)
+                i += 2 + n_args
+
+            else:
+                rsp.append((header & ~0xf) | INFO_BAD_HEADER)
+                break
+        return rsp
+
+
+def make_endpoint(addr_table, design=None, clk_hz=31.25e6, **kwargs):
+    """Endpoint emulating the design of an address table."""
+    if design is None:
+        design = os.path.splitext(os.path.basename(addr_table))[0]
+    if design not in DESIGNS:
+        raise ValueError('no model of design %s ( known: %s )' % (design, ', '.join(sorted(DESIGNS))))
+    endpoints = read_endpoints(addr_table)
+    built = DESIGNS[design](endpoints, clk_hz)
+    slaves, tester = built if isinstance(built, tuple) else (built, None)
+    return Endpoint(AddressMap(endpoints, slaves), tick=tester.advance if tester else None, **kwargs)
+
+
+def serve(endpoint, host, port, verbose=False):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    sock.bind((host, port))
+    print('IPbus UDP emulator listening on %s:%d' % (host, sock.getsockname()[1]), flush=True)
+
+    t_report = time.monotonic()
+    while True:
+        data, client = sock.recvfrom(65536)
+        rsp = endpoint.handle(data)
+        if rsp is not None:
+            sock.sendto(rsp, client)
+        if verbose and time.monotonic() - t_report > 1.0:
+            t_report = time.monotonic()
+            print(' '.join('%s=%d' % kv for kv in sorted(endpoint.stats.items())), flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('addr_table', help='ram_slaves_tester.xml or ctr_slaves_tester.xml')
+    parser.add_argument('--design', choices=sorted(DESIGNS), help='design to emulate ( default: from the address table name )')
+    parser.add_argument('--host', default='0.0.0.0')
+    parser.add_argument('-p', '--port', type=int, default=50001)
+    parser.add_argument('--clk-mhz', type=float, default=31.25, help='clock of the test engine ( clk of the design )')
+    parser.add_argument('--mtu', type=int, default=1500, help='MTU reported in status responses')
+    parser.add_argument('--buffers', type=int, default=16, help='response buffers reported in status responses, and kept for re-send')
+    parser.add_argument('-v', '--verbose', action='store_true', help='print packet counts every second')
+    args = parser.parse_args()
+
+    try:
+        endpoint = make_endpoint(args.addr_table, args.design, args.clk_mhz * 1e6, mtu=args.mtu, buffers=args.buffers)
+    except (ValueError, ET.ParseError, OSError) as e:
+        print('ERROR: %s' % e)
+        return 1
+
+    try:
+        serve(endpoint, args.host, args.port, args.verbose)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
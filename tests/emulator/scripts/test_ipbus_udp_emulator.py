@@ -0,0 +1,139 @@
+import os
+import socket
+import threading
+import time
+
+import pytest
+
+import ipbus_udp_emulator as emu
+from ipbus_udp_benchmark import Client, IPbusError
+
+TESTS_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+CTR_TABLE = os.path.join(TESTS_DIR, 'ctr_slaves', 'addr_table', 'ctr_slaves_tester.xml')
+RAM_TABLE = os.path.join(TESTS_DIR, 'ram_slaves', 'addr_table', 'ram_slaves_tester.xml')
+
+
+def start(addr_table):
+    endpoint = emu.make_endpoint(addr_table)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('127.0.0.1', 0))
+
+    def loop():
+        while True:
+            data, client = sock.recvfrom(65536)
+            rsp = endpoint.handle(data)
+            if rsp is not None:
+                sock.sendto(rsp, client)
+
+    threading.Thread(target=loop, daemon=True).start()
+    return Client('127.0.0.1', sock.getsockname()[1]), emu.read_endpoints(addr_table)
+
+
+@pytest.fixture(scope='module')
+def ctr():
+    return start(CTR_TABLE)
+
+
+@pytest.fixture(scope='module')
+def ram():
+    return start(RAM_TABLE)
+
+
+def ram_words(value, bits):
+    n = 1 if bits <= 32 else 2 if bits <= 64 else 4
+    return [(value >> (32 * i)) & ((1 << max(0, min(32, bits - 32 * i))) - 1) for i in range(n)]
+
+
+def run_action(hw, nodes, slaves, channels, increment, count, wait=0):
+    base = nodes['testctrl'][0]
+    hw.write(base, [(slaves << 16) | channels, (int(increment) << 31) | (wait << 28) | count, 0])
+    hw.write(base + 2, [1])
+    while hw.read(base + 4)[0] & 0x1:
+        time.sleep(0.001)
+
+
+def test_packet_ids(ctr):
+    hw, nodes = ctr
+    mtu, buffers, next_id = hw.status()
+    done = hw.packet([(0, nodes['csr'][0] + 1, 1)])
+    hw.sock.send(done)
+    hw.sock.recv(65536)
+    assert hw.status()[2] == next_id % 0xffff + 1
+
+    # Out of sequence packets are dropped, answered ones can be re-sent
+    hw.next_id = next_id + 5
+    hw.sock.send(hw.packet([(0, nodes['csr'][0] + 1, 1)]))
+    with pytest.raises(socket.timeout):
+        hw.sock.recv(65536)
+    assert hw.status()[2] == next_id % 0xffff + 1
+    hw.sock.send(bytes([0x20, done[1], done[2], 0xf2]))
+    assert Client.decode(hw.sock.recv(65536)) == [(0, 0, [0xabcdfedc])]
+
+
+def test_bus_error(ctr):
+    hw, nodes = ctr
+    with pytest.raises(IPbusError):
+        hw.read(0xdead0000)
+    with pytest.raises(IPbusError):
+        hw.read(nodes['csr'][0], 3)
+
+
+def test_counters(ctr):
+    hw, nodes = ctr
+    hw.write(nodes['csr'][0], [1])
+    hw.write(nodes['csr'][0], [0])
+    small = nodes['ctrs.block.small'][0]
+    wide = nodes['ctrs.block.large_wide'][0]
+    wraps = nodes['ctrs.block.large_wide_wraps'][0]
+    readreset = nodes['ctrs.block.large_wide_readreset'][0]
+
+    run_action(hw, nodes, 0x3d, 0x1f, True, 1000, wait=2)
+    assert hw.read(small) == [1000]
+    assert hw.read(wide, 10) == [1000, 0] * 5
+    assert hw.read(readreset, 10) == [1000, 0] * 5
+    assert hw.read(readreset, 10) == [0] * 10
+
+    # Load from the references, then saturate and wrap
+    hw.write(nodes['ctrs.block.small_rw'][0], [0xfffffffe])
+    assert hw.read(nodes['ctrs.block.small_rw'][0] + 1) == [0xfffffffe]
+    run_action(hw, nodes, 0x2, 0x1, True, 5)
+    assert hw.read(nodes['ctrs.block.small_rw'][0] + 1) == [0xffffffff]
+    run_action(hw, nodes, 0x10, 0x1, False, 1001)
+    assert hw.read(wraps, 2) == [0xffffffff, 0xffffffff]
+
+    # Ported: sampled at word 0 only
+    ported = nodes['ctrs.ported.large_wide'][0]
+    run_action(hw, nodes, 0x800, 0x4, True, 7)
+    hw.write(ported, [0])
+    assert hw.read(ported + 1, 10, incr=False)[4:6] == [7, 0]
+    run_action(hw, nodes, 0x800, 0x4, True, 1)
+    hw.write(ported, [4])
+    assert hw.read(ported + 1, 1, incr=False) == [7]
+
+    # Snapshot of the live values, not reset by it
+    snapshot = nodes['snapshot'][0]
+    hw.write(snapshot, [1])
+    assert hw.read(snapshot + 0x40, 40)[20:30] == [0, 0, 0, 0, 8, 0, 0, 0, 0, 0]
+
+
+def test_ram_pattern(ram):
+    hw, nodes = ram
+    patt_gen = nodes['patt_gen'][0]
+    hw.rmw_bits(patt_gen, 0, (0x5a << 24) | (1 << 1) | 0x1)
+    assert hw.read(nodes['dpram'][0] + 10, 2) == [0x5a5a5a5a] * 2
+    assert hw.read(nodes['dpram36'][0] + 20, 2) == [0x5a5a5a5a, 0xa]
+    assert hw.read(nodes['sdpram72'][0] + 4, 4) == [0x5a5a5a5a, 0x5a5a5a5a, 0x5a, 0]
+
+    hw.write(patt_gen, [(2 << 1) | 0x1])
+    chunks = lambda addr: sum((((i & 0x3) << 16) | addr) << (18 * i) for i in range(4))
+    hw.write(nodes['ported_dpram72'][0], [4 * 3])
+    assert hw.read(nodes['ported_dpram72'][0] + 1, 4, incr=False) == ram_words(chunks(3), 72)
+    assert hw.read(nodes['dpram36'][0] + 2 * 7, 2) == ram_words(chunks(7), 36)
+
+    # sdpram72 can not be written from IPbus, the other RAMs can
+    hw.write(nodes['sdpram72'][0], [1, 2, 3, 4])
+    assert hw.read(nodes['sdpram72'][0], 4) == ram_words(chunks(0), 72)
+    hw.write(nodes['ported_ram'][0], [1023])
+    hw.write(nodes['ported_ram'][0] + 1, [0x11, 0x22], incr=False)
+    hw.write(nodes['ported_ram'][0], [0])
+    assert hw.read(nodes['ported_ram'][0] + 1, 1, incr=False) == [0x22]
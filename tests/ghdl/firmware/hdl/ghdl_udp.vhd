@@ -0,0 +1,94 @@
+---------------------------------------------------------------------------------
+--
+--   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+--
+--   Licensed under the Apache License, Version 2.0 (the "License");
+--   you may not use this file except in compliance with the License.
+--   You may obtain a copy of the License at
+--
+--       http://www.apache.org/licenses/LICENSE-2.0
+--
+--   Unless required by applicable law or agreed to in writing, software
+--   distributed under the License is distributed on an "AS IS" BASIS,
+--   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--   See the License for the specific language governing permissions and
+--   limitations under the License.
+--
+--                                     - - -
+--
+--   Additional information about ipbus-firmare and the list of ipbus-firmware
+--   contacts are available at
+--
+--       https://ipbus.web.cern.ch/ipbus
+--
+---------------------------------------------------------------------------------
+
+
+
+-- ghdl_udp
+--
+-- UDP socket for GHDL simulations, through VHPIDIRECT calls into ghdl_udp.c
+-- (built into ghdl_udp.so by run_ghdl_regression.py). One socket per
+-- simulation; packets are handled a whole one at a time, as 32b words in
+-- network byte order.
+--
+-- The bodies below are never run: GHDL calls the C functions instead.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+
+package ghdl_udp is
+
+	-- Bind the UDP port. Returns 0, or -1 on error
+	impure function ghdl_udp_open(port_num: integer) return integer;
+	attribute foreign of ghdl_udp_open: function is "VHPIDIRECT ./ghdl_udp.so ghdl_udp_open";
+
+	-- Wait up to timeout_us for a packet. Returns its length in words, or 0
+	impure function ghdl_udp_recv(timeout_us: integer) return integer;
+	attribute foreign of ghdl_udp_recv: function is "VHPIDIRECT ./ghdl_udp.so ghdl_udp_recv";
+
+	-- Word i of the last packet received
+	impure function ghdl_udp_get(i: integer) return integer;
+	attribute foreign of ghdl_udp_get: function is "VHPIDIRECT ./ghdl_udp.so ghdl_udp_get";
+
+	-- Set word i of the next packet to send
+	procedure ghdl_udp_put(i: integer; word: integer);
+	attribute foreign of ghdl_udp_put: procedure is "VHPIDIRECT ./ghdl_udp.so ghdl_udp_put";
+
+	-- Send n words to the sender of the last packet received
+	procedure ghdl_udp_send(n: integer);
+	attribute foreign of ghdl_udp_send: procedure is "VHPIDIRECT ./ghdl_udp.so ghdl_udp_send";
+
+end ghdl_udp;
+
+package body ghdl_udp is
+
+	impure function ghdl_udp_open(port_num: integer) return integer is
+	begin
+		assert false report "VHPIDIRECT ghdl_udp_open" severity failure;
+		return -1;
+	end function;
+
+	impure function ghdl_udp_recv(timeout_us: integer) return integer is
+	begin
+		assert false report "VHPIDIRECT ghdl_udp_recv" severity failure;
+		return 0;
+	end function;
+
+	impure function ghdl_udp_get(i: integer) return integer is
+	begin
+		assert false report "VHPIDIRECT ghdl_udp_get" severity failure;
+		return 0;
+	end function;
+
+	procedure ghdl_udp_put(i: integer; word: integer) is
+	begin
+		assert false report "VHPIDIRECT ghdl_udp_put" severity failure;
+	end procedure;
+
+	procedure ghdl_udp_send(n: integer) is
+	begin
+		assert false report "VHPIDIRECT ghdl_udp_send" severity failure;
+	end procedure;
+
+end ghdl_udp;
@@ -0,0 +1,285 @@
+---------------------------------------------------------------------------------
+--
+--   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+--
+--   Licensed under the Apache License, Version 2.0 (the "License");
+--   you may not use this file except in compliance with the License.
+--   You may obtain a copy of the License at
+--
+--       http://www.apache.org/licenses/LICENSE-2.0
+--
+--   Unless required by applicable law or agreed to in writing, software
+--   distributed under the License is distributed on an "AS IS" BASIS,
+--   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--   See the License for the specific language governing permissions and
+--   limitations under the License.
+--
+--                                     - - -
+--
+--   Additional information about ipbus-firmare and the list of ipbus-firmware
+--   contacts are available at
+--
+--       https://ipbus.web.cern.ch/ipbus
+--
+---------------------------------------------------------------------------------
+
+
+
+-- ipbus_udp_ghdl
+--
+-- Behavioural IPbus 2.0 UDP endpoint for GHDL simulations, standing in for the
+-- ModelSim FLI transport of boards/sim. Packets from ghdl_udp are carried out
+-- on ipb_out / ipb_in one word at a time, and answered. Control, status and
+-- re-send packets, packet ID checks and both byte orders are handled as by
+-- ipbus_ctrl.
+--
+-- While no packets arrive the socket is polled every POLL_CYCLES clocks. After
+-- IDLE_POLLS empty polls each poll waits up to 1ms of real time, so that an
+-- idle simulation does not spin.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+use work.ipbus.all;
+use work.ghdl_udp.all;
+
+entity ipbus_udp_ghdl is
+	generic(
+		UDP_PORT: natural := 50001;
+		N_BUFFERS: positive := 4;
+		POLL_CYCLES: positive := 32;
+		IDLE_POLLS: natural := 1000;
+		BUS_TIMEOUT: positive := 256
+	);
+	port(
+		clk: in std_logic;
+		rst: in std_logic;
+		ipb_out: out ipb_wbus;
+		ipb_in: in ipb_rbus
+	);
+
+end ipbus_udp_ghdl;
+
+architecture behavioural of ipbus_udp_ghdl is
+
+	constant MAX_WORDS: positive := 2048; -- RX / TX buffer size in ghdl_udp.c
+	constant MTU: natural := 1500;
+
+	subtype word_t is std_logic_vector(31 downto 0);
+	type words_t is array(0 to MAX_WORDS - 1) of word_t;
+	type buffers_t is array(0 to N_BUFFERS - 1) of words_t;
+	type naturals_t is array(0 to N_BUFFERS - 1) of natural;
+
+	constant BUS_OK: natural := 0;
+	constant BUS_ERROR: natural := 1;
+	constant BUS_TIMED_OUT: natural := 2;
+
+	function swap(w: word_t) return word_t is
+	begin
+		return w(7 downto 0) & w(15 downto 8) & w(23 downto 16) & w(31 downto 24);
+	end function;
+
+	function is_pkt_header(w: word_t) return boolean is
+	begin
+		return w(31 downto 28) = X"2" and w(7 downto 4) = X"f";
+	end function;
+
+begin
+
+	process
+
+		variable rx, tx: words_t;
+		variable sent: buffers_t;
+		variable sent_len, sent_id: naturals_t := (others => 0);
+		variable next_buf: natural := 0;
+		variable next_id: natural := 1;
+		variable n_rx, n_tx, idle, i, n, n_args, n_done, rsp, stat, pkt_id, trans_type: natural;
+		variable swapped, bad: boolean;
+		variable th, rdata: word_t;
+		variable addr: unsigned(31 downto 0);
+		variable info: std_logic_vector(3 downto 0);
+
+		procedure xact(write: in boolean; wdata: in word_t; rdata: out word_t; stat: out natural) is
+			variable cycles: natural := 0;
+		begin
+			ipb_out.ipb_addr <= std_logic_vector(addr);
+			ipb_out.ipb_wdata <= wdata;
+			if write then
+				ipb_out.ipb_write <= '1';
+			else
+				ipb_out.ipb_write <= '0';
+			end if;
+			ipb_out.ipb_strobe <= '1';
+			loop
+				wait until rising_edge(clk);
+				exit when ipb_in.ipb_ack = '1' or ipb_in.ipb_err = '1' or cycles = BUS_TIMEOUT;
+				cycles := cycles + 1;
+			end loop;
+			rdata := ipb_in.ipb_rdata;
+			if ipb_in.ipb_ack = '1' then
+				stat := BUS_OK;
+			elsif ipb_in.ipb_err = '1' then
+				stat := BUS_ERROR;
+			else
+				stat := BUS_TIMED_OUT;
+			end if;
+			ipb_out.ipb_strobe <= '0';
+			wait until rising_edge(clk);
+		end procedure;
+
+	begin
+		ipb_out <= IPB_WBUS_NULL;
+		wait until rising_edge(clk) and rst = '0';
+		assert ghdl_udp_open(UDP_PORT) = 0
+			report "ipbus_udp_ghdl: can not bind UDP port " & integer'image(UDP_PORT) severity failure;
+		report "ipbus_udp_ghdl: listening on UDP port " & integer'image(UDP_PORT) severity note;
+
+		idle := 0;
+		loop
+			if idle < IDLE_POLLS then
+				n_rx := ghdl_udp_recv(0);
+			else
+				n_rx := ghdl_udp_recv(1000);
+			end if;
+
+			if n_rx = 0 then
+				idle := idle + 1;
+				for c in 1 to POLL_CYCLES loop
+					wait until rising_edge(clk);
+				end loop;
+				next;
+			end if;
+			idle := 0;
+
+			for j in 0 to n_rx - 1 loop
+				rx(j) := std_logic_vector(to_signed(ghdl_udp_get(j), 32));
+			end loop;
+			swapped := not is_pkt_header(rx(0)) and is_pkt_header(swap(rx(0)));
+			if swapped then
+				for j in 0 to n_rx - 1 loop
+					rx(j) := swap(rx(j));
+				end loop;
+			end if;
+
+			n_tx := 0;
+			pkt_id := to_integer(unsigned(rx(0)(23 downto 8)));
+
+			if not is_pkt_header(rx(0)) then
+				null;
+
+			elsif rx(0)(3 downto 0) = X"1" then -- status
+				tx(0) := rx(0);
+				tx(1) := std_logic_vector(to_unsigned(MTU, 32));
+				tx(2) := std_logic_vector(to_unsigned(N_BUFFERS, 32));
+				tx(3) := X"20" & std_logic_vector(to_unsigned(next_id, 16)) & X"f0";
+				for j in 4 to 15 loop
+					tx(j) := (others => '0');
+				end loop;
+				n_tx := 16;
+
+			elsif rx(0)(3 downto 0) = X"2" then -- re-send
+				for b in 0 to N_BUFFERS - 1 loop
+					if sent_len(b) /= 0 and sent_id(b) = pkt_id then
+						tx(0 to sent_len(b) - 1) := sent(b)(0 to sent_len(b) - 1);
+						n_tx := sent_len(b);
+					end if;
+				end loop;
+
+			elsif rx(0)(3 downto 0) = X"0" and (pkt_id = 0 or pkt_id = next_id) then -- control
+				tx(0) := rx(0);
+				n_tx := 1;
+				i := 1;
+				while i < n_rx loop
+					th := rx(i);
+					n := to_integer(unsigned(th(15 downto 8)));
+					trans_type := to_integer(unsigned(th(7 downto 4)));
+					case trans_type is
+						when 0 | 2 => n_args := 0;
+						when 1 | 3 => n_args := n;
+						when 4 => n_args := 2;
+						when 5 => n_args := 1;
+						when others => n_args := 0;
+					end case;
+					bad := th(31 downto 28) /= X"2" or th(3 downto 0) /= X"f" or trans_type > 5 or
+						i + 2 + n_args > n_rx or n_tx + 1 + n > MAX_WORDS;
+					if bad then
+						tx(n_tx) := th(31 downto 4) & X"1";
+						n_tx := n_tx + 1;
+						exit;
+					end if;
+
+					addr := unsigned(rx(i + 1));
+					rsp := n_tx;
+					n_tx := n_tx + 1;
+					n_done := 0;
+					stat := BUS_OK;
+					case trans_type is
+						when 0 | 2 => -- read, non-incrementing read
+							for j in 0 to n - 1 loop
+								xact(false, (others => '0'), rdata, stat);
+								exit when stat /= BUS_OK;
+								tx(n_tx) := rdata;
+								n_tx := n_tx + 1;
+								n_done := n_done + 1;
+								if trans_type = 0 then
+									addr := addr + 1;
+								end if;
+							end loop;
+						when 1 | 3 => -- write, non-incrementing write
+							for j in 0 to n - 1 loop
+								xact(true, rx(i + 2 + j), rdata, stat);
+								exit when stat /= BUS_OK;
+								n_done := n_done + 1;
+								if trans_type = 1 then
+									addr := addr + 1;
+								end if;
+							end loop;
+						when others => -- RMW bits, RMW sum
+							xact(false, (others => '0'), rdata, stat);
+							if stat = BUS_OK then
+								tx(n_tx) := rdata;
+								n_tx := n_tx + 1;
+								n_done := 1;
+								if trans_type = 4 then
+									xact(true, (rdata and rx(i + 2)) or rx(i + 3), rdata, stat);
+								else
+									xact(true, std_logic_vector(unsigned(rdata) + unsigned(rx(i + 2))), rdata, stat);
+								end if;
+							end if;
+					end case;
+
+					if stat = BUS_OK then
+						info := X"0";
+					elsif trans_type = 1 or trans_type = 3 then
+						info := std_logic_vector(to_unsigned(3 + 2 * stat, 4)); -- 0x5 bus error, 0x7 timeout on write
+					else
+						info := std_logic_vector(to_unsigned(2 + 2 * stat, 4)); -- 0x4 bus error, 0x6 timeout on read
+					end if;
+					tx(rsp) := th(31 downto 16) & std_logic_vector(to_unsigned(n_done, 8)) & th(7 downto 4) & info;
+					exit when stat /= BUS_OK;
+					i := i + 2 + n_args;
+				end loop;
+
+				if pkt_id /= 0 then
+					sent(next_buf)(0 to n_tx - 1) := tx(0 to n_tx - 1);
+					sent_len(next_buf) := n_tx;
+					sent_id(next_buf) := pkt_id;
+					next_buf := (next_buf + 1) mod N_BUFFERS;
+					next_id := pkt_id mod 65535 + 1;
+				end if;
+			end if;
+
+			if n_tx > 0 then
+				for j in 0 to n_tx - 1 loop
+					if swapped then
+						ghdl_udp_put(j, to_integer(signed(swap(tx(j)))));
+					else
+						ghdl_udp_put(j, to_integer(signed(tx(j))));
+					end if;
+				end loop;
+				ghdl_udp_send(n_tx);
+			end if;
+		end loop;
+	end process;
+
+end behavioural;
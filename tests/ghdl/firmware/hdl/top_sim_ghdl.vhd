@@ -0,0 +1,94 @@
+---------------------------------------------------------------------------------
+--
+--   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+--
+--   Licensed under the Apache License, Version 2.0 (the "License");
+--   you may not use this file except in compliance with the License.
+--   You may obtain a copy of the License at
+--
+--       http://www.apache.org/licenses/LICENSE-2.0
+--
+--   Unless required by applicable law or agreed to in writing, software
+--   distributed under the License is distributed on an "AS IS" BASIS,
+--   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--   See the License for the specific language governing permissions and
+--   limitations under the License.
+--
+--                                     - - -
+--
+--   Additional information about ipbus-firmare and the list of ipbus-firmware
+--   contacts are available at
+--
+--       https://ipbus.web.cern.ch/ipbus
+--
+---------------------------------------------------------------------------------
+
+
+
+-- top_sim_ghdl
+--
+-- Top level for running an ipbus test payload in GHDL: ipbus_udp_ghdl on UDP
+-- port UDP_PORT in place of the ModelSim sim_udp board, with the same clocks
+-- ( 31.25MHz ipbus, 40MHz payload ). soft_rst from the payload resets it, as
+-- on the boards.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use work.ipbus.all;
+
+entity top is
+	generic(
+		UDP_PORT: natural := 50001
+	);
+
+end top;
+
+architecture rtl of top is
+
+	constant IPB_CLK_PERIOD: time := 32 ns;
+	constant CLK_PERIOD: time := 25 ns;
+
+	signal ipb_clk, clk: std_logic := '0';
+	signal ipb_rst: std_logic := '1';
+	signal rst, soft_rst: std_logic := '1';
+	signal ipbw: ipb_wbus;
+	signal ipbr: ipb_rbus;
+
+begin
+
+	ipb_clk <= not ipb_clk after IPB_CLK_PERIOD / 2;
+	clk <= not clk after CLK_PERIOD / 2;
+	ipb_rst <= '0' after 10 * IPB_CLK_PERIOD;
+
+	process(clk)
+	begin
+		if rising_edge(clk) then
+			rst <= ipb_rst or soft_rst;
+		end if;
+	end process;
+
+	udp: entity work.ipbus_udp_ghdl
+		generic map(
+			UDP_PORT => UDP_PORT
+		)
+		port map(
+			clk => ipb_clk,
+			rst => ipb_rst,
+			ipb_out => ipbw,
+			ipb_in => ipbr
+		);
+
+	payload: entity work.payload
+		port map(
+			ipb_clk => ipb_clk,
+			ipb_rst => ipb_rst,
+			ipb_in => ipbw,
+			ipb_out => ipbr,
+			clk => clk,
+			rst => rst,
+			nuke => open,
+			soft_rst => soft_rst,
+			userled => open
+		);
+
+end rtl;
@@ -0,0 +1,145 @@
+/*-------------------------------------------------------------------------------
+ *
+ *   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ *                                     - - -
+ *
+ *   Additional information about ipbus-firmare and the list of ipbus-firmware
+ *   contacts are available at
+ *
+ *       https://ipbus.web.cern.ch/ipbus
+ *
+ *-------------------------------------------------------------------------------*/
+
+/*
+ * ghdl_udp.c
+ *
+ * UDP socket for GHDL simulations, called through VHPIDIRECT from the ghdl_udp
+ * package ( ghdl_udp.vhd ). Build as a shared library:
+ *
+ *   cc -shared -fPIC -O2 -o ghdl_udp.so ghdl_udp.c
+ *
+ * Readiness: if IPBUS_SIM_READY is set to host:port, "ready <udp port>\n" is
+ * sent to that TCP address once the UDP port is bound, so that test scripts
+ * can start as soon as the simulation is listening instead of sleeping.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MAX_WORDS 2048 // MAX_WORDS in ipbus_udp_ghdl.vhd
+
+static int sock = -1;
+static struct sockaddr_in peer;
+static uint32_t rx[MAX_WORDS];
+static uint32_t tx[MAX_WORDS];
+
+static void notify_ready(int32_t port_num) {
+  const char* target = getenv("IPBUS_SIM_READY");
+  if (target == NULL || *target == '\0')
+    return;
+
+  char host[64];
+  const char* colon = strrchr(target, ':');
+  if (colon == NULL || colon - target >= (long) sizeof(host)) {
+    fprintf(stderr, "ghdl_udp: bad IPBUS_SIM_READY '%s', expected host:port\n", target);
+    return;
+  }
+  memcpy(host, target, colon - target);
+  host[colon - target] = '\0';
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(atoi(colon + 1));
+  if (inet_pton(AF_INET, strcmp(host, "localhost") ? host : "127.0.0.1", &addr.sin_addr) != 1) {
+    fprintf(stderr, "ghdl_udp: bad IPBUS_SIM_READY host '%s'\n", host);
+    return;
+  }
+
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  char msg[32];
+  int len = snprintf(msg, sizeof(msg), "ready %d\n", port_num);
+  if (s < 0 || connect(s, (struct sockaddr*) &addr, sizeof(addr)) < 0 || write(s, msg, len) != len)
+    fprintf(stderr, "ghdl_udp: readiness notification to %s failed: %s\n", target, strerror(errno));
+  if (s >= 0)
+    close(s);
+}
+
+int32_t ghdl_udp_open(int32_t port_num) {
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    perror("ghdl_udp: socket");
+    return -1;
+  }
+
+  int one = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port_num);
+  if (bind(sock, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+    perror("ghdl_udp: bind");
+    close(sock);
+    sock = -1;
+    return -1;
+  }
+
+  notify_ready(port_num);
+  return 0;
+}
+
+int32_t ghdl_udp_recv(int32_t timeout_us) {
+  struct pollfd pfd = { sock, POLLIN, 0 };
+  if (sock < 0 || poll(&pfd, 1, (timeout_us + 999) / 1000) <= 0)
+    return 0;
+
+  socklen_t peer_len = sizeof(peer);
+  ssize_t len = recvfrom(sock, rx, sizeof(rx), 0, (struct sockaddr*) &peer, &peer_len);
+  if (len < 4)
+    return 0;
+
+  int32_t n = len / 4;
+  for (int32_t i = 0; i < n; i++)
+    rx[i] = ntohl(rx[i]);
+  return n;
+}
+
+int32_t ghdl_udp_get(int32_t i) {
+  return (i >= 0 && i < MAX_WORDS) ? (int32_t) rx[i] : 0;
+}
+
+void ghdl_udp_put(int32_t i, int32_t word) {
+  if (i >= 0 && i < MAX_WORDS)
+    tx[i] = htonl((uint32_t) word);
+}
+
+void ghdl_udp_send(int32_t n) {
+  if (sock < 0 || n <= 0 || n > MAX_WORDS)
+    return;
+  if (sendto(sock, tx, n * 4, 0, (struct sockaddr*) &peer, sizeof(peer)) < 0)
+    perror("ghdl_udp: sendto");
+}
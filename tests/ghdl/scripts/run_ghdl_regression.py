@@ -0,0 +1,442 @@
+#!/usr/bin/env python3
+"""
+Build and run the simulation testbenches with GHDL, in parallel, and write a
+JUnit report. This is the open source alternative to the ModelSim scripts in
+tests/ci ( test-run-sim-*.sh ).
+
+e.g.
+  python3 run_ghdl_regression.py                      # everything, one job per core
+  python3 run_ghdl_regression.py -k neo430 -j 4
+  python3 run_ghdl_regression.py --list
+
+Sources come from the ipbb dep files of each project, resolved against the
+packages in --src ( the src directory of an ipbb work area, by default the one
+holding this repository ). Unqualified components are looked up in the
+package of the dep file first, then in the other packages. Libraries set by
+setup .tcl files ( set_property library ... ) are honoured.
+
+Two kinds of test:
+  self-checking   the testbench runs to the end. A report of severity error or
+                  failure fails it ( --assert-level=error )
+  udp             the payload runs behind ipbus_udp_ghdl ( tests/ghdl ) on its
+                  own UDP port. The simulation tells the runner when it is
+                  listening ( IPBUS_SIM_READY, see ghdl_udp.c ), then the client
+                  command runs against it and decides the result
+
+Each project is built once, then all the tests run at the same time, up to
+--jobs. Per-test times go to the console and the JUnit report. The total time
+goes to --metrics ( GitLab metrics report format ).
+
+CI ( run_ghdl_regression in ci/sim.yml ) runs the self-checking tests on the
+ghdl/ghdl image. That image has no uHAL, so the udp tests only run where it is
+installed. The testbenches have not been through GHDL outside CI yet, so a
+failure in the first pipeline is more likely to be GHDL rejecting the source
+than a real bug.
+"""
+
+import argparse
+import collections
+import concurrent.futures
+import os
+import re
+import shlex
+import signal
+import socket
+import subprocess
+import sys
+import threading
+import time
+import xml.etree.ElementTree as ET
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.normpath(os.path.join(SCRIPT_DIR, os.pardir, os.pardir, os.pardir))
+UDP_LIB_SRC = os.path.join(REPO, 'tests', 'ghdl', 'firmware', 'sim', 'ghdl_udp.c')
+UDP_LIB = 'ghdl_udp.so'  # name in the foreign attributes of ghdl_udp.vhd
+
+VHDL_EXTS = ('.vhd', '.vhdl')
+IGNORED_EXTS = ('.xci', '.xcix', '.xdc', '.tcl', '.coe', '.mem', '.ngc', '.edn', '.dcp', '.xml')
+
+# Project: dep files ( component, file ) in this repository, and top level entity
+PROJECTS = {
+    'ram_slaves': ([('tests/ghdl', 'ghdl_udp.dep'), ('tests/ram_slaves', 'ram_slaves_tester.dep')], 'top'),
+    'ctr_slaves': ([('tests/ghdl', 'ghdl_udp.dep'), ('tests/ctr_slaves', 'ctr_slaves_tester.dep')], 'top'),
+    'neo430_wrapper': ([('tests/neo430_wrapper', 'top_sim.dep')], 'top'),
+    'ipbus_arb': ([('tests/ipbus_arb', 'top_sim.dep')], 'top'),
+    'latency_hist': ([('tests/latency_hist', 'top_sim.dep')], 'top'),
+    'i2c_trace': ([('tests/i2c_trace', 'top_sim.dep')], 'top'),
+}
+
+RAM_ADDR = os.path.join(REPO, 'tests', 'ram_slaves', 'addr_table', 'ram_slaves_tester.xml')
+CTR_ADDR = os.path.join(REPO, 'tests', 'ctr_slaves', 'addr_table', 'ctr_slaves_tester.xml')
+
+Test = collections.namedtuple('Test', 'name project generics client')
+
+# client: command run against a udp test ( {port} is its UDP port ), None for self-checking tests
+TESTS = [
+    Test('ram_slaves', 'ram_slaves', {}, [
+        sys.executable, os.path.join(REPO, 'tests', 'ram_slaves', 'software', 'test-ram-tests.py'),
+        '--client', 'ipbusudp-2.0://localhost:{port}', '--addr', 'file://' + RAM_ADDR, '--wait', '0.5']),
+    Test('ctr_slaves', 'ctr_slaves', {}, [
+        sys.executable, '-m', 'pytest', '-x', '-v', os.path.join(REPO, 'tests', 'ctr_slaves', 'scripts', 'test_ctr_slaves.py'),
+        '--client', 'ipbusudp-2.0://localhost:{port}', '--addr', 'file://' + CTR_ADDR]),
+    # The boot scenarios of test-run-sim-neo430.sh
+    Test('neo430_prom', 'neo430_wrapper', {}, None),
+    Test('neo430_clk125', 'neo430_wrapper', {'CLOCK_SPEED': '125000000'}, None),
+    Test('neo430_link_static', 'neo430_wrapper', {'IPBUS_LINK': 'true'}, None),
+    Test('neo430_link_rarp', 'neo430_wrapper', {'IPBUS_LINK': 'true', 'PROM_RARP': 'true'}, None),
+    Test('neo430_link_rarp_slow', 'neo430_wrapper', {'IPBUS_LINK': 'true', 'PROM_RARP': 'true', 'RARP_DELAY_US': '20000'}, None),
+    Test('neo430_link_rarp_loss', 'neo430_wrapper', {'IPBUS_LINK': 'true', 'PROM_RARP': 'true', 'RARP_PATTERN': 'DDR'}, None),
+    Test('ipbus_arb', 'ipbus_arb', {}, None),
+    Test('latency_hist', 'latency_hist', {}, None),
+    Test('i2c_trace', 'i2c_trace', {}, None),
+    Test('i2c_trace_min', 'i2c_trace', {'DEPTH_BITS': '4'}, None),
+]
+
+# Testbench lines worth showing in the summary, as grepped by the ModelSim scripts
+SUMMARY_RE = re.compile(r'set at|released at|Boot to link|first reply|Aggregate throughput|Jain fairness|Latency histogram|I2C trace|passed|failed')
+
+
+class DepError(Exception):
+    pass
+
+
+class DepResolver:
+    """Source files and libraries of ipbb dep files."""
+
+    VALUE_OPTS = {'-c': 'component', '--component': 'component', '-l': 'lib', '--lib': 'lib', '--cd': 'cd',
+                  '-u': 'usein', '--usein': 'usein', '-t': 'toolset', '--toolset': 'toolset'}
+
+    def __init__(self, src_root):
+        self.packages = {name: os.path.join(src_root, name) for name in sorted(os.listdir(src_root))
+                         if os.path.isdir(os.path.join(src_root, name))}
+        self.sources = []  # ( library, path )
+        self.libraries = {}  # file name -> library, from setup .tcl files
+        self._seen = set()
+
+    def package_of(self, path):
+        path = os.path.realpath(path)
+        for name, root in self.packages.items():
+            root = os.path.realpath(root)
+            if path == root or path.startswith(root + os.sep):
+                return name
+        raise DepError('%s is not in a package of the source area' % path)
+
+    def component_dir(self, package, component):
+        if ':' in component:
+            package, component = component.split(':', 1)
+            if package not in self.packages:
+                raise DepError('package %s not in the source area' % package)
+            return package, os.path.join(self.packages[package], component)
+        candidates = [package] + [p for p in self.packages if p != package]
+        for p in candidates:
+            path = os.path.join(self.packages[p], component)
+            if os.path.isdir(path):
+                return p, path
+        raise DepError('component %s not found in any package' % component)
+
+    def include(self, package, component, dep_file):
+        package, comp_dir = self.component_dir(package, component)
+        path = os.path.normpath(os.path.join(comp_dir, 'firmware', 'cfg', dep_file))
+        if path in self._seen:
+            return
+        self._seen.add(path)
+        if not os.path.isfile(path):
+            raise DepError('dep file %s not found' % path)
+
+        with open(path) as f:
+            for lineno, line in enumerate(f, 1):
+                line = line.split('#', 1)[0].strip()
+                if not line or line.startswith('@') or line.startswith('?'):
+                    continue
+                try:
+                    self._command(package, component, shlex.split(line))
+                except DepError as e:
+                    raise DepError('%s:%d: %s' % (path, lineno, e))
+
+    def _command(self, package, component, tokens):
+        cmd, opts, args = tokens[0], {}, []
+        i = 1
+        while i < len(tokens):
+            if tokens[i] in self.VALUE_OPTS:
+                opts[self.VALUE_OPTS[tokens[i]]] = tokens[i + 1]
+                i += 2
+            elif tokens[i].startswith('-'):
+                i += 1  # flags ( --vhdl2008, -f ... )
+            else:
+                args.append(tokens[i])
+                i += 1
+        comp = opts.get('component', component)
+
+        if cmd == 'include':
+            for dep_file in args or ['top.dep']:
+                self.include(package, comp, dep_file)
+        elif cmd == 'src':
+            pkg, comp_dir = self.component_dir(package, comp)
+            base = os.path.join(comp_dir, 'firmware', 'hdl', opts.get('cd', ''))
+            for name in args:
+                self._source(os.path.normpath(os.path.join(base, name)), opts.get('lib', 'work'))
+        elif cmd == 'setup':
+            pkg, comp_dir = self.component_dir(package, comp)
+            for name in args:
+                self._setup(os.path.normpath(os.path.join(comp_dir, 'firmware', 'cfg', name)))
+        # addrtab, util, iprepo ... do not matter to the simulation
+
+    def _source(self, path, library):
+        if path.endswith(VHDL_EXTS):
+            if not os.path.isfile(path):
+                raise DepError('source %s not found' % path)
+            if path not in (p for lib, p in self.sources):
+                self.sources.append((library, path))
+        elif not path.endswith(IGNORED_EXTS):
+            print('WARNING: %s is not VHDL, left out of the GHDL build' % path)
+
+    def _setup(self, path):
+        if not os.path.isfile(path):
+            raise DepError('setup file %s not found' % path)
+        with open(path) as f:
+            for lib, name in re.findall(r'set_property\s+library\s+(\S+)\s+\[get_files\s+(\S+?)\]', f.read()):
+                self.libraries[name] = lib
+
+    def files(self):
+        """[ ( library, path ) ] in dep order."""
+        return [(self.libraries.get(os.path.basename(p), lib), p) for lib, p in self.sources]
+
+
+class Result:
+    def __init__(self, name, classname):
+        self.name = name
+        self.classname = classname
+        self.status = 'passed'
+        self.message = ''
+        self.time = 0.0
+        self.output = ''
+
+
+class Runner:
+
+    def __init__(self, args):
+        self.args = args
+        self.ghdl = args.ghdl
+        self.flags = ['--std=08', '-fsynopsys', '-frelaxed'] + shlex.split(args.ghdl_flags)
+        version = subprocess.run([self.ghdl, '--version'], stdout=subprocess.PIPE, universal_newlines=True).stdout
+        self.mcode = 'mcode' in version
+        self.print_lock = threading.Lock()
+        self.ports = iter(range(args.base_port, args.base_port + 1000))
+        self.port_lock = threading.Lock()
+
+    def log(self, msg):
+        with self.print_lock:
+            print(msg, flush=True)
+
+    def work_dir(self, project):
+        return os.path.join(os.path.abspath(self.args.work), project)
+
+    def run(self, cmd, cwd, timeout, log):
+        """Run cmd, appending its output to log. Return ( exit code, output )."""
+        proc = subprocess.run(cmd, cwd=cwd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                              universal_newlines=True, timeout=timeout)
+        with open(log, 'a') as f:
+            f.write('$ %s\n%s\n' % (' '.join(cmd), proc.stdout))
+        return proc.returncode, proc.stdout
+
+    def build(self, project):
+        result = Result('build', 'ghdl.' + project)
+        t_start = time.monotonic()
+        wd = self.work_dir(project)
+        os.makedirs(wd, exist_ok=True)
+        log = os.path.join(wd, 'build.log')
+        open(log, 'w').close()
+        try:
+            resolver = DepResolver(self.args.src)
+            deps, top = PROJECTS[project]
+            package = resolver.package_of(REPO)
+            for component, dep_file in deps:
+                resolver.include(package, component, dep_file)
+            files = resolver.files()
+
+            elab_flags = []
+            if any(os.path.basename(p) == 'ghdl_udp.vhd' for lib, p in files):
+                rc, out = self.run(['cc', '-shared', '-fPIC', '-O2', '-o', UDP_LIB, UDP_LIB_SRC], wd, 300, log)
+                if rc:
+                    raise DepError('building %s failed:\n%s' % (UDP_LIB, out))
+                if not self.mcode:
+                    elab_flags.append('-Wl,' + os.path.join(wd, UDP_LIB))
+
+            libs = []
+            for lib, path in files:
+                if lib not in libs:
+                    libs.append(lib)
+            for lib in libs:
+                cmd = [self.ghdl, '-i'] + self.flags + ['--workdir=.', '--work=%s' % lib] + [p for l, p in files if l == lib]
+                rc, out = self.run(cmd, wd, 600, log)
+                if rc:
+                    raise DepError('importing library %s failed:\n%s' % (lib, out))
+            rc, out = self.run([self.ghdl, '-m'] + self.flags + ['--workdir=.', '-P.'] + elab_flags + [top], wd, 1800, log)
+            if rc:
+                raise DepError('analysis / elaboration failed:\n%s' % out)
+            result.output = '%d files in %s' % (len(files), ', '.join(libs))
+        except (DepError, OSError, subprocess.TimeoutExpired) as e:
+            result.status = 'error'
+            result.message = str(e)
+        result.time = time.monotonic() - t_start
+        self.log('%-24s %-7s %7.1f s   %s' % (project + ' build', result.status, result.time,
+                                             result.output if result.status == 'passed' else result.message.splitlines()[0]))
+        return result
+
+    def sim_cmd(self, test):
+        _, top = PROJECTS[test.project]
+        cmd = [self.ghdl, '-r'] + self.flags + ['--workdir=.', '-P.', top]
+        cmd += ['-g%s=%s' % kv for kv in sorted(test.generics.items())]
+        return cmd + ['--assert-level=error', '--ieee-asserts=disable-at-0']
+
+    def run_test(self, test):
+        result = Result(test.name, 'ghdl.' + test.project)
+        wd = self.work_dir(test.project)
+        log = os.path.join(wd, test.name + '.log')
+        open(log, 'w').close()
+        t_start = time.monotonic()
+        try:
+            if test.client is None:
+                rc, out = self.run(self.sim_cmd(test), wd, self.args.timeout, log)
+                result.output = out
+                if rc:
+                    result.status = 'failed'
+                    result.message = 'simulation exit code %d' % rc
+            else:
+                self.run_udp_test(test, wd, log, result)
+        except subprocess.TimeoutExpired:
+            result.status = 'failed'
+            result.message = 'timeout after %d s' % self.args.timeout
+        except OSError as e:
+            result.status = 'error'
+            result.message = str(e)
+        result.time = time.monotonic() - t_start
+
+        summary = [l.strip() for l in result.output.splitlines() if SUMMARY_RE.search(l)]
+        self.log('%-24s %-7s %7.1f s   %s' % (test.name, result.status, result.time, result.message))
+        if self.args.verbose or result.status != 'passed':
+            for line in (summary if result.status == 'passed' else result.output.splitlines()[-20:]):
+                self.log('    ' + line)
+        return result
+
+    def run_udp_test(self, test, wd, log, result):
+        with self.port_lock:
+            port = next(self.ports)
+        ready = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        ready.bind(('127.0.0.1', 0))
+        ready.listen(1)
+        ready.settimeout(self.args.ready_timeout)
+        env = dict(os.environ, IPBUS_SIM_READY='127.0.0.1:%d' % ready.getsockname()[1])
+
+        cmd = self.sim_cmd(test._replace(generics=dict(test.generics, UDP_PORT=str(port))))
+        sim_log = open(os.path.join(wd, test.name + '.sim.log'), 'w')
+        sim = subprocess.Popen(cmd, cwd=wd, env=env, stdout=sim_log, stderr=subprocess.STDOUT, start_new_session=True)
+        try:
+            try:
+                conn, _ = ready.accept()
+                msg = conn.recv(64).decode(errors='replace')
+                conn.close()
+            except socket.timeout:
+                msg = ''
+            if not msg.startswith('ready'):
+                result.status = 'error'
+                result.message = 'simulation not ready after %g s' % self.args.ready_timeout
+                return
+
+            client = [arg.format(port=port) for arg in test.client]
+            rc, out = self.run(client, wd, self.args.timeout, log)
+            result.output = out
+            if rc:
+                result.status = 'failed'
+                result.message = 'client exit code %d' % rc
+            elif sim.poll() is not None:
+                result.status = 'failed'
+                result.message = 'simulation stopped, exit code %d' % sim.returncode
+        finally:
+            ready.close()
+            if sim.poll() is None:
+                os.killpg(sim.pid, signal.SIGTERM)
+                try:
+                    sim.wait(10)
+                except subprocess.TimeoutExpired:
+                    os.killpg(sim.pid, signal.SIGKILL)
+                    sim.wait()
+            sim_log.close()
+            with open(sim_log.name) as f:
+                result.output += f.read()
+
+
+def write_junit(fname, results, elapsed):
+    suite = ET.Element('testsuite', name='ghdl_regression', tests=str(len(results)),
+                       failures=str(sum(r.status == 'failed' for r in results)),
+                       errors=str(sum(r.status == 'error' for r in results)),
+                       time='%.3f' % elapsed, timestamp=time.strftime('%Y-%m-%dT%H:%M:%S'))
+    for r in results:
+        case = ET.SubElement(suite, 'testcase', classname=r.classname, name=r.name, time='%.3f' % r.time)
+        if r.status != 'passed':
+            ET.SubElement(case, 'failure' if r.status == 'failed' else 'error', message=r.message).text = r.message
+        if r.output:
+            ET.SubElement(case, 'system-out').text = r.output
+    root = ET.Element('testsuites')
+    root.append(suite)
+    ET.ElementTree(root).write(fname, encoding='utf-8', xml_declaration=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-k', dest='filter', action='append', default=[], help='only run tests whose name contains this ( repeatable )')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count(), help='parallel builds / simulations ( default: all cores )')
+    parser.add_argument('--src', default=os.path.dirname(REPO), help='ipbb source area holding the packages')
+    parser.add_argument('--work', default='ghdl_regression', help='build directory')
+    parser.add_argument('--ghdl', default='ghdl')
+    parser.add_argument('--ghdl-flags', default='', help='extra GHDL options, e.g. -P for precompiled vendor libraries')
+    parser.add_argument('--base-port', type=int, default=50101, help='first UDP port for the udp tests')
+    parser.add_argument('--timeout', type=float, default=1800, help='seconds allowed per test')
+    parser.add_argument('--ready-timeout', type=float, default=120, help='seconds for a udp simulation to start listening')
+    parser.add_argument('--junit', default='ghdl_regression.xml', help='JUnit report')
+    parser.add_argument('--metrics', default='ghdl_regression_metrics.txt', help='GitLab metrics report')
+    parser.add_argument('--list', action='store_true', help='list the tests and exit')
+    parser.add_argument('-v', '--verbose', action='store_true', help='show the testbench summary lines of passing tests')
+    args = parser.parse_args()
+
+    tests = [t for t in TESTS if not args.filter or any(k in t.name for k in args.filter)]
+    if args.list:
+        for t in tests:
+            print('%-24s %-16s %s' % (t.name, t.project, 'udp' if t.client else 'self-checking'))
+        return 0
+    if not tests:
+        print('ERROR: no tests match %s' % ', '.join(args.filter))
+        return 1
+
+    t_start = time.monotonic()
+    runner = Runner(args)
+    projects = sorted(set(t.project for t in tests))
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        builds = dict(zip(projects, pool.map(runner.build, projects)))
+        t_built = time.monotonic()
+        to_run = [t for t in tests if builds[t.project].status == 'passed']
+        results = list(builds.values()) + list(pool.map(runner.run_test, to_run))
+    for t in tests:
+        if t not in to_run:
+            r = Result(t.name, 'ghdl.' + t.project)
+            r.status = 'error'
+            r.message = 'build of %s failed' % t.project
+            results.append(r)
+    elapsed = time.monotonic() - t_start
+
+    write_junit(args.junit, results, elapsed)
+    n_failed = sum(r.status != 'passed' for r in results)
+    with open(args.metrics, 'w') as f:
+        f.write('ghdl_regression_seconds %.1f\n' % elapsed)
+        f.write('ghdl_regression_build_seconds %.1f\n' % (t_built - t_start))
+        f.write('ghdl_regression_tests %d\n' % len(tests))
+        f.write('ghdl_regression_failures %d\n' % n_failed)
+
+    print('%d tests, %d builds, %d failed or errors, %.1f s in total ( %.1f s building ), %d jobs' % (
+        len(tests), len(projects), n_failed, elapsed, t_built - t_start, args.jobs))
+    print('JUnit report: %s' % args.junit)
+    return 1 if n_failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,351 @@
+---------------------------------------------------------------------------------
+--
+--   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+--
+--   Licensed under the Apache License, Version 2.0 (the "License");
+--   you may not use this file except in compliance with the License.
+--   You may obtain a copy of the License at
+--
+--       http://www.apache.org/licenses/LICENSE-2.0
+--
+--   Unless required by applicable law or agreed to in writing, software
+--   distributed under the License is distributed on an "AS IS" BASIS,
+--   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--   See the License for the specific language governing permissions and
+--   limitations under the License.
+--
+--                                     - - -
+--
+--   Additional information about ipbus-firmare and the list of ipbus-firmware
+--   contacts are available at
+--
+--       https://ipbus.web.cern.ch/ipbus
+--
+---------------------------------------------------------------------------------
+
+
+
+-- ipbus_i2c_trace_tb
+--
+-- Test of ipbus_i2c_trace, the passive I2C bus trace of te0712_infra. As on
+-- the board, the trace runs on the soft core clock without a reset, and IPbus
+-- is held in reset while the first I2C traffic goes by ( as the NEO430 does
+-- until it has read the PROM ). That traffic, a stuck bus recovery then a
+-- write and a read with a repeated START and a NACK, must be in the ring
+-- without any setup, with the time between two bytes right and a glitch on
+-- SCL filtered out. Then the NACK trigger with a few events after it, and the
+-- address trigger after the ring has wrapped, are checked, and that a write
+-- that leaves the arm bit set does not arm again.
+--
+-- Errors are reported with severity error, and the clock is stopped so that
+-- 'run -all' returns.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+use work.ipbus.all;
+
+entity top is
+	generic(
+		DEPTH_BITS: positive := 5
+	);
+end top;
+
+architecture tb of top is
+
+	constant CLK_PERIOD: time := 8 ns; -- 125MHz, the soft core clock with NEO430_CLK125
+	constant IPB_PERIOD: time := 32 ns; -- 31.25MHz
+	constant TS_SHIFT: natural := 3;
+	constant FILTER: positive := 4;
+	constant Q: time := 1 us; -- quarter of an I2C bit ( 250kHz )
+	constant DEPTH: positive := 2 ** DEPTH_BITS;
+
+	-- ipbus_i2c_trace.xml
+	constant A_CTRL: natural := 16#0#;
+	constant A_POST: natural := 16#1#;
+	constant A_STATUS: natural := 16#8#;
+	constant A_EVENTS: natural := 16#9#;
+	constant A_TRIG_PTR: natural := 16#a#;
+	constant A_CONFIG: natural := 16#c#;
+	constant A_CLOCK: natural := 16#d#;
+	constant A_RING: natural := DEPTH;
+
+	constant EV_START: natural := 1;
+	constant EV_RESTART: natural := 2;
+	constant EV_STOP: natural := 3;
+	constant EV_ADDR: natural := 4;
+	constant EV_DATA: natural := 5;
+	constant EV_PARTIAL: natural := 6;
+
+	constant TRIG_NACK: natural := 3;
+	constant TRIG_ADDR: natural := 2;
+	constant CTRL_ARM: natural := 16#10#;
+
+	signal clk: std_logic := '1';
+	signal ipb_clk: std_logic := '1';
+	signal ipb_rst: std_logic := '1';
+	signal stop: boolean := false;
+	signal scl, sda: std_logic := '1';
+	signal ipbw: ipb_wbus := IPB_WBUS_NULL;
+	signal ipbr: ipb_rbus;
+
+begin
+
+	clk <= not clk after CLK_PERIOD / 2 when not stop;
+	ipb_clk <= not ipb_clk after IPB_PERIOD / 2 when not stop;
+
+	dut: entity work.ipbus_i2c_trace
+		generic map(
+			DEPTH_BITS => DEPTH_BITS,
+			TS_SHIFT => TS_SHIFT,
+			FILTER => FILTER,
+			CLOCK_SPEED => 125000000
+		)
+		port map(
+			ipb_clk => ipb_clk,
+			ipb_rst => ipb_rst,
+			ipb_in => ipbw,
+			ipb_out => ipbr,
+			clk => clk,
+			rst => '0',
+			scl_i => scl,
+			sda_i => sda
+		);
+
+	stim: process
+
+		variable errors: natural := 0;
+		variable d: std_logic_vector(31 downto 0);
+
+		procedure xact(addr: in natural; write: in boolean; wdata: in std_logic_vector(31 downto 0); rdata: out std_logic_vector(31 downto 0)) is
+		begin
+			wait until rising_edge(ipb_clk);
+			ipbw.ipb_addr <= std_logic_vector(to_unsigned(addr, 32));
+			ipbw.ipb_wdata <= wdata;
+			if write then
+				ipbw.ipb_write <= '1';
+			else
+				ipbw.ipb_write <= '0';
+			end if;
+			ipbw.ipb_strobe <= '1';
+			wait until rising_edge(ipb_clk) and (ipbr.ipb_ack = '1' or ipbr.ipb_err = '1');
+			assert ipbr.ipb_err = '0' report "Bus error at address " & integer'image(addr) severity error;
+			rdata := ipbr.ipb_rdata;
+			ipbw <= IPB_WBUS_NULL;
+		end procedure;
+
+		procedure write_reg(addr, value: in natural) is
+		begin
+			xact(addr, true, std_logic_vector(to_unsigned(value, 32)), d);
+		end procedure;
+
+		procedure check(what: in string; got, expected: in std_logic_vector) is
+		begin
+			if got /= expected then
+				report what & ": read " & integer'image(to_integer(unsigned(got))) & ", expected " &
+					integer'image(to_integer(unsigned(expected))) severity error;
+				errors := errors + 1;
+			end if;
+		end procedure;
+
+		procedure check_n(what: in string; addr, expected: in natural) is
+		begin
+			xact(addr, false, (others => '0'), d);
+			check(what, d(30 downto 0), std_logic_vector(to_unsigned(expected, 31)));
+		end procedure;
+
+		-- bit 31 = triggered, 30 = done, 29 = wrapped, bits DEPTH_BITS-1..0 = next ring address ( the lines are not checked )
+		procedure check_status(what: in string; triggered, done, wrapped: in std_logic; wptr: in natural) is
+		begin
+			xact(A_STATUS, false, (others => '0'), d);
+			check(what & ", status", d(31 downto 29) & d(DEPTH_BITS - 1 downto 0),
+				triggered & done & wrapped & std_logic_vector(to_unsigned(wptr, DEPTH_BITS)));
+		end procedure;
+
+		-- Type, NACK and byte of the event at ring address n ( and the bit count, for a partial byte )
+		procedure check_event(n, kind: in natural; byte: in natural := 0; nack: in std_logic := '0'; bits: in natural := 0) is
+			variable exp: std_logic_vector(15 downto 0);
+		begin
+			xact(A_RING + n, false, (others => '0'), d);
+			exp := std_logic_vector(to_unsigned(kind, 3)) & nack & std_logic_vector(to_unsigned(byte, 8)) & std_logic_vector(to_unsigned(bits, 4));
+			if kind /= EV_PARTIAL then
+				d(19 downto 16) := "0000";
+			end if;
+			check("Event " & integer'image(n), d(31 downto 16), exp);
+		end procedure;
+
+		-- The bus, driven as a master would ( and a slave for the ACK bits )
+		procedure i2c_start is
+		begin
+			sda <= '1';
+			scl <= '1';
+			wait for Q;
+			sda <= '0';
+			wait for Q;
+			scl <= '0';
+			wait for Q;
+		end procedure;
+
+		procedure i2c_restart is
+		begin
+			sda <= '1';
+			wait for Q;
+			scl <= '1';
+			wait for Q;
+			sda <= '0';
+			wait for Q;
+			scl <= '0';
+			wait for Q;
+		end procedure;
+
+		procedure i2c_stop is
+		begin
+			sda <= '0';
+			wait for Q;
+			scl <= '1';
+			wait for Q;
+			sda <= '1';
+			wait for 4 * Q;
+		end procedure;
+
+		-- A glitch is a pulse on SCL shorter than the filter, while it is low
+		procedure i2c_bit(b: in std_logic; glitch: in boolean := false) is
+		begin
+			sda <= b;
+			wait for Q / 2;
+			if glitch then
+				scl <= '1';
+				wait for (FILTER - 2) * CLK_PERIOD;
+				scl <= '0';
+			end if;
+			wait for Q / 2;
+			scl <= '1';
+			wait for 2 * Q;
+			scl <= '0';
+			wait for Q;
+		end procedure;
+
+		procedure i2c_byte(b: in natural; nack: in std_logic := '0'; glitch: in boolean := false) is
+			variable v: std_logic_vector(7 downto 0);
+		begin
+			v := std_logic_vector(to_unsigned(b, 8));
+			for i in 7 downto 0 loop
+				i2c_bit(v(i), glitch and i = 3);
+			end loop;
+			i2c_bit(nack);
+		end procedure;
+
+		-- START, address byte and one data byte, STOP: four events
+		procedure i2c_write1(addr, b: in natural; nack: in std_logic := '0') is
+		begin
+			i2c_start;
+			i2c_byte(addr);
+			i2c_byte(b, nack);
+			i2c_stop;
+		end procedure;
+
+	begin
+		wait for 10 * IPB_PERIOD;
+
+		-- IPbus in reset: a stuck bus recovery ( nine SCL pulses and a STOP ), then a write of the PROM
+		-- address and a read of two bytes, the last one NACKed
+		scl <= '0';
+		wait for Q;
+		for i in 1 to 9 loop
+			i2c_bit('1');
+		end loop;
+		i2c_stop;
+		i2c_start;
+		i2c_byte(16#a0#);
+		i2c_byte(16#00#, '0', true);
+		i2c_restart;
+		i2c_byte(16#a1#);
+		i2c_byte(16#fa#);
+		i2c_byte(16#12#, '1');
+		i2c_stop;
+
+		ipb_rst <= '0';
+		wait for 10 * IPB_PERIOD;
+
+		check_n("Config", A_CONFIG, DEPTH_BITS + TS_SHIFT * 256 + FILTER * 65536);
+		check_n("Clock", A_CLOCK, 125000);
+		check_status("Boot", '1', '0', '0', 10);
+		check_n("Boot, events", A_EVENTS, 10);
+		check_n("Boot, trigger address", A_TRIG_PTR, 0);
+		check_event(0, EV_PARTIAL, 16#ff#, '0', 9);
+		check_event(1, EV_STOP);
+		check_event(2, EV_START);
+		check_event(3, EV_ADDR, 16#a0#);
+		check_event(4, EV_DATA, 16#00#);
+		check_event(5, EV_RESTART);
+		check_event(6, EV_ADDR, 16#a1#);
+		check_event(7, EV_DATA, 16#fa#);
+		check_event(8, EV_DATA, 16#12#, '1');
+		check_event(9, EV_STOP);
+
+		-- Two bytes are nine bits ( 36us ) apart, 562.5 time units of 64ns
+		xact(A_RING + 4, false, (others => '0'), d);
+		if to_integer(unsigned(d(19 downto 0))) < 561 or to_integer(unsigned(d(19 downto 0))) > 564 then
+			report "Time between two bytes: " & integer'image(to_integer(unsigned(d(19 downto 0)))) &
+				" units, expected 562 or 563" severity error;
+			errors := errors + 1;
+		end if;
+		report "I2C trace: boot sequence of 10 events recorded with IPbus in reset, bytes " &
+			integer'image(to_integer(unsigned(d(19 downto 0)))) & " units apart" severity note;
+
+		-- NACK trigger, three events from it on
+		write_reg(A_POST, 3);
+		write_reg(A_CTRL, TRIG_NACK + CTRL_ARM);
+		write_reg(A_CTRL, TRIG_NACK);
+		wait for 1 us;
+		check_status("Armed for a NACK", '0', '0', '0', 0);
+		i2c_write1(16#a0#, 16#01#);
+		i2c_write1(16#a2#, 16#66#, '1');
+		i2c_write1(16#a0#, 16#02#);
+		check_status("NACK trigger", '1', '1', '0', 9);
+		check_n("NACK trigger, events", A_EVENTS, 9);
+		check_n("NACK trigger, trigger address", A_TRIG_PTR, 6);
+		check_event(5, EV_ADDR, 16#a2#);
+		check_event(6, EV_DATA, 16#66#, '1');
+		check_event(7, EV_STOP);
+		check_event(8, EV_START);
+
+		-- Address trigger after the ring has wrapped: only the last DEPTH events are kept
+		write_reg(A_POST, 4);
+		write_reg(A_CTRL, TRIG_ADDR + 16#a1# * 256 + 16#ff# * 65536 + CTRL_ARM);
+		write_reg(A_CTRL, TRIG_ADDR + 16#a1# * 256 + 16#ff# * 65536);
+		for i in 1 to 12 loop
+			i2c_write1(16#a0#, i);
+		end loop;
+		check_status("Before the address", '0', '0', '1', 48 mod DEPTH);
+		i2c_write1(16#a1#, 16#77#, '1');
+		i2c_write1(16#a0#, 16#00#);
+		check_status("Address trigger", '1', '1', '1', 53 mod DEPTH);
+		check_n("Address trigger, events", A_EVENTS, 53);
+		check_n("Address trigger, trigger address", A_TRIG_PTR, 49 mod DEPTH);
+		check_event(49 mod DEPTH, EV_ADDR, 16#a1#);
+		check_event(50 mod DEPTH, EV_DATA, 16#77#, '1');
+		check_event(52 mod DEPTH, EV_START);
+		check_event(53 mod DEPTH, EV_ADDR, 16#a0#); -- the oldest kept
+
+		-- Arm and leave the bit set. Writing the register again, as a masked write of another
+		-- field does, must not arm again
+		write_reg(A_CTRL, TRIG_ADDR + 16#a1# * 256 + 16#ff# * 65536 + CTRL_ARM);
+		i2c_write1(16#a0#, 16#00#);
+		wait for 1 us;
+		check_n("Armed, events", A_EVENTS, 4);
+		write_reg(A_CTRL, TRIG_ADDR + 16#a1# * 256 + 16#ff# * 65536 + CTRL_ARM);
+		wait for 1 us;
+		check_n("Written again with arm set, events", A_EVENTS, 4);
+
+		if errors = 0 then
+			report "I2C trace test passed" severity note;
+		else
+			report "I2C trace test failed: " & integer'image(errors) & " errors" severity error;
+		end if;
+		stop <= true;
+		wait;
+	end process;
+
+end tb;
@@ -0,0 +1,189 @@
+---------------------------------------------------------------------------------
+--
+--   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+--
+--   Licensed under the Apache License, Version 2.0 (the "License");
+--   you may not use this file except in compliance with the License.
+--   You may obtain a copy of the License at
+--
+--       http://www.apache.org/licenses/LICENSE-2.0
+--
+--   Unless required by applicable law or agreed to in writing, software
+--   distributed under the License is distributed on an "AS IS" BASIS,
+--   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--   See the License for the specific language governing permissions and
+--   limitations under the License.
+--
+--                                     - - -
+--
+--   Additional information about ipbus-firmare and the list of ipbus-firmware
+--   contacts are available at
+--
+--       https://ipbus.web.cern.ch/ipbus
+--
+---------------------------------------------------------------------------------
+
+
+-- ipbus_arb_rr_tb
+--
+-- Load test for ipbus_arb_rr: N_MASTERS behavioural ipbus masters (modelled on
+-- the ipb_req / ipb_grant behaviour of ipbus_ctrl) hammer the block RAMs of
+-- ram_slaves_tester through the arbiter. Each master writes and reads back its
+-- own region of the 'ram' and 'dpram' endpoints, so that any mix-up between
+-- masters shows up as a data mismatch.
+--
+-- At the end the aggregate throughput and the Jain fairness index of the
+-- per-master transaction counts (taken while all masters were still busy) are
+-- reported, and the clock is stopped so that 'run -all' returns.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+use work.ipbus.all;
+use work.ipbus_reg_types.all;
+
+entity top is
+	generic(
+		N_MASTERS: positive := 2;
+		N_PKTS: positive := 256; -- packets per master
+		PKT_WORDS: positive := 16; -- words written then read back per packet
+		MIN_FAIRNESS: real := 0.99
+	);
+end top;
+
+architecture tb of top is
+
+	constant CLK_PERIOD: time := 32 ns; -- 31.25MHz ipbus clock
+	constant REGION: natural := 16#100#; -- words per master in each RAM
+	type base_array_t is array(0 to 1) of natural;
+	constant RAM_BASE: base_array_t := (16#1000#, 16#2000#); -- 'ram' and 'dpram' in ram_slaves_tester.xml
+
+	signal clk: std_logic := '0';
+	signal rst: std_logic := '1';
+	signal stop: boolean := false;
+	signal ipb_m_out: ipb_wbus_array(N_MASTERS - 1 downto 0);
+	signal ipb_m_in: ipb_rbus_array(N_MASTERS - 1 downto 0);
+	signal ipb_req, ipb_grant, done: std_logic_vector(N_MASTERS - 1 downto 0) := (others => '0');
+	signal ipbw: ipb_wbus;
+	signal ipbr: ipb_rbus;
+	signal stat: ipb_reg_v(3 * N_MASTERS - 1 downto 0);
+
+begin
+
+	clk <= not clk after CLK_PERIOD / 2 when not stop;
+	rst <= '0' after 10 * CLK_PERIOD;
+
+	arb: entity work.ipbus_arb_rr
+		generic map(
+			N_BUS => N_MASTERS
+		)
+		port map(
+			clk => clk,
+			rst => rst,
+			ipb_m_out => ipb_m_out,
+			ipb_m_in => ipb_m_in,
+			ipb_req => ipb_req,
+			ipb_grant => ipb_grant,
+			ipb_out => ipbw,
+			ipb_in => ipbr,
+			stat => stat
+		);
+
+	slaves: entity work.ram_slaves_tester
+		port map(
+			ipb_clk => clk,
+			ipb_rst => rst,
+			ipb_in => ipbw,
+			ipb_out => ipbr,
+			clk => clk,
+			rst => rst,
+			nuke => open,
+			soft_rst => open,
+			userled => open
+		);
+
+	gen_m: for m in N_MASTERS - 1 downto 0 generate
+
+		master: process
+
+			procedure xact(addr: in natural; write: in boolean; wdata: in std_logic_vector(31 downto 0); rdata: out std_logic_vector(31 downto 0)) is
+			begin
+				ipb_m_out(m).ipb_addr <= std_logic_vector(to_unsigned(addr, 32));
+				ipb_m_out(m).ipb_wdata <= wdata;
+				if write then
+					ipb_m_out(m).ipb_write <= '1';
+				else
+					ipb_m_out(m).ipb_write <= '0';
+				end if;
+				ipb_m_out(m).ipb_strobe <= '1';
+				wait until rising_edge(clk) and (ipb_m_in(m).ipb_ack = '1' or ipb_m_in(m).ipb_err = '1');
+				assert ipb_m_in(m).ipb_err = '0'
+					report "Master " & integer'image(m) & ": bus error at address " & integer'image(addr) severity error;
+				rdata := ipb_m_in(m).ipb_rdata;
+			end procedure;
+
+			variable addr, n: natural;
+			variable d, q: std_logic_vector(31 downto 0);
+
+		begin
+			ipb_m_out(m) <= IPB_WBUS_NULL;
+			wait until rst = '0';
+			for p in 0 to N_PKTS - 1 loop
+				ipb_req(m) <= '1';
+				wait until rising_edge(clk) and ipb_grant(m) = '1';
+				for w in 0 to PKT_WORDS - 1 loop
+					n := p * PKT_WORDS + w;
+					addr := RAM_BASE(n mod 2) + m * REGION + (n / 2) mod REGION;
+					d := std_logic_vector(to_unsigned(m, 4)) & std_logic_vector(to_unsigned(n, 28));
+					xact(addr, true, d, q);
+					xact(addr, false, (others => '0'), q);
+					assert q = d
+						report "Master " & integer'image(m) & ": readback mismatch at address " & integer'image(addr) severity error;
+				end loop;
+				ipb_m_out(m) <= IPB_WBUS_NULL;
+				ipb_req(m) <= '0';
+				wait until rising_edge(clk);
+			end loop;
+			done(m) <= '1';
+			wait;
+		end process;
+
+	end generate;
+
+	monitor: process
+		variable t_start, t_end: time;
+		variable x, sum_x, sum_x2, jain, rate: real;
+	begin
+		wait until rst = '0';
+		t_start := now;
+
+		-- Fairness is only meaningful while every master is competing for the bus
+		wait until rising_edge(clk) and unsigned(done) /= 0;
+		sum_x := 0.0;
+		sum_x2 := 0.0;
+		for m in 0 to N_MASTERS - 1 loop
+			x := real(to_integer(unsigned(stat(3 * m + 1))));
+			sum_x := sum_x + x;
+			sum_x2 := sum_x2 + x * x;
+			report "Master " & integer'image(m) & ": " & integer'image(to_integer(unsigned(stat(3 * m + 1)))) & " transactions in " &
+				integer'image(to_integer(unsigned(stat(3 * m)))) & " packets, " &
+				integer'image(to_integer(unsigned(stat(3 * m + 2)))) & " cycles waiting for grant" severity note;
+		end loop;
+		jain := (sum_x * sum_x) / (real(N_MASTERS) * sum_x2);
+
+		wait until rising_edge(clk) and unsigned(not done) = 0;
+		t_end := now;
+		rate := real(N_MASTERS * N_PKTS * PKT_WORDS * 2) / real((t_end - t_start) / 1 ns) * 1.0e3;
+
+		report "Aggregate throughput: " & real'image(rate) & " Mtransactions/s (" &
+			real'image(rate * real(CLK_PERIOD / 1 ps) * 1.0e-6) & " per clock)" severity note;
+		report "Jain fairness index: " & real'image(jain) severity note;
+		assert jain >= MIN_FAIRNESS
+			report "Arbitration is unfair: Jain index " & real'image(jain) & " < " & real'image(MIN_FAIRNESS) severity error;
+
+		stop <= true;
+		wait;
+	end process;
+
+end tb;
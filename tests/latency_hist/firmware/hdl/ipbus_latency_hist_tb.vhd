@@ -0,0 +1,416 @@
+---------------------------------------------------------------------------------
+--
+--   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+--
+--   Licensed under the Apache License, Version 2.0 (the "License");
+--   you may not use this file except in compliance with the License.
+--   You may obtain a copy of the License at
+--
+--       http://www.apache.org/licenses/LICENSE-2.0
+--
+--   Unless required by applicable law or agreed to in writing, software
+--   distributed under the License is distributed on an "AS IS" BASIS,
+--   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--   See the License for the specific language governing permissions and
+--   limitations under the License.
+--
+--                                     - - -
+--
+--   Additional information about ipbus-firmare and the list of ipbus-firmware
+--   contacts are available at
+--
+--       https://ipbus.web.cern.ch/ipbus
+--
+---------------------------------------------------------------------------------
+
+
+
+-- ipbus_latency_hist_tb
+--
+-- Test of ipbus_latency_hist: request and response frames are played into its
+-- MAC side with known gaps (the transmit side with gaps in mac_tx_ready), and
+-- the statistics and every histogram bin read back over ipbus are checked
+-- against the latencies seen by the testbench. The frames include traffic that
+-- must be ignored (ARP, another MAC address, status packets), a request that
+-- is never answered, responses without a request and more requests in flight
+-- than the queue holds. Freeze and clear are checked at the end, including
+-- that a write of freeze which leaves clear set does not clear again.
+--
+-- Errors are reported with severity error, and the clock is stopped so that
+-- 'run -all' returns.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+use work.ipbus.all;
+
+entity top is
+	generic(
+		QUEUE_BITS: positive := 3
+	);
+end top;
+
+architecture tb of top is
+
+	constant MAC_PERIOD: time := 8 ns; -- 125MHz
+	constant IPB_PERIOD: time := 32 ns; -- 31.25MHz
+	constant HIST_BITS: positive := 10;
+	constant BIN_SHIFT: natural := 4;
+	constant N_BINS: positive := 2 ** HIST_BITS;
+	constant IPBUS_PORT: natural := 50001;
+	constant HOST_PORT: natural := 60123;
+	constant MAC: std_logic_vector(47 downto 0) := x"020ddba11599";
+	constant HOST_MAC: std_logic_vector(47 downto 0) := x"020ddba11500";
+	constant FRAME_LEN: positive := 64;
+
+	-- ipbus_latency_hist.xml
+	constant A_CTRL: natural := 16#0#;
+	constant A_STAT: natural := 16#10#;
+	constant A_HIST: natural := 16#400#;
+
+	type frame_t is array(0 to FRAME_LEN - 1) of std_logic_vector(7 downto 0);
+	type hist_t is array(0 to N_BINS - 1) of natural;
+	type time_array_t is array(natural range <>) of time;
+
+	-- Ethernet / IPv4 / UDP frame with an IPbus packet header ( ptype 0 = control, 1 = status )
+	function frame(dst: std_logic_vector(47 downto 0); ethertype: std_logic_vector(15 downto 0);
+		src_port, dst_port, id, ptype: natural) return frame_t is
+		variable f: frame_t := (others => x"00");
+		variable p: std_logic_vector(15 downto 0);
+	begin
+		for i in 0 to 5 loop
+			f(i) := dst(47 - 8 * i downto 40 - 8 * i);
+			f(6 + i) := x"a5";
+		end loop;
+		f(12) := ethertype(15 downto 8);
+		f(13) := ethertype(7 downto 0);
+		f(14) := x"45";
+		f(22) := x"40";
+		f(23) := x"11";
+		p := std_logic_vector(to_unsigned(src_port, 16));
+		f(34) := p(15 downto 8);
+		f(35) := p(7 downto 0);
+		p := std_logic_vector(to_unsigned(dst_port, 16));
+		f(36) := p(15 downto 8);
+		f(37) := p(7 downto 0);
+		p := std_logic_vector(to_unsigned(id, 16));
+		f(42) := x"20";
+		f(43) := p(15 downto 8);
+		f(44) := p(7 downto 0);
+		f(45) := x"f" & std_logic_vector(to_unsigned(ptype, 4));
+		for i in 46 to FRAME_LEN - 1 loop
+			f(i) := std_logic_vector(to_unsigned(i, 8));
+		end loop;
+		return f;
+	end function;
+
+	function request(id: natural) return frame_t is
+	begin
+		return frame(MAC, x"0800", HOST_PORT, IPBUS_PORT, id, 0);
+	end function;
+
+	function response(id: natural) return frame_t is
+	begin
+		return frame(HOST_MAC, x"0800", IPBUS_PORT, HOST_PORT, id, 0);
+	end function;
+
+	signal mac_clk, ipb_clk: std_logic := '0';
+	signal rst_macclk, ipb_rst: std_logic := '1';
+	signal stop: boolean := false;
+	signal ipbw: ipb_wbus := IPB_WBUS_NULL;
+	signal ipbr: ipb_rbus;
+	signal rx_data, tx_data: std_logic_vector(7 downto 0) := (others => '0');
+	signal rx_valid, rx_last, rx_error, tx_valid, tx_last, tx_error: std_logic := '0';
+	signal tx_ready: std_logic := '1';
+
+begin
+
+	mac_clk <= not mac_clk after MAC_PERIOD / 2 when not stop;
+	ipb_clk <= not ipb_clk after IPB_PERIOD / 2 when not stop;
+	rst_macclk <= '0' after 10 * IPB_PERIOD;
+	ipb_rst <= '0' after 10 * IPB_PERIOD;
+
+	dut: entity work.ipbus_latency_hist
+		generic map(
+			IPBUS_PORT => IPBUS_PORT,
+			HIST_BITS => HIST_BITS,
+			BIN_SHIFT => BIN_SHIFT,
+			QUEUE_BITS => QUEUE_BITS
+		)
+		port map(
+			ipb_clk => ipb_clk,
+			ipb_rst => ipb_rst,
+			ipb_in => ipbw,
+			ipb_out => ipbr,
+			mac_clk => mac_clk,
+			rst_macclk => rst_macclk,
+			mac_addr => MAC,
+			mac_rx_data => rx_data,
+			mac_rx_valid => rx_valid,
+			mac_rx_last => rx_last,
+			mac_rx_error => rx_error,
+			mac_tx_data => tx_data,
+			mac_tx_valid => tx_valid,
+			mac_tx_last => tx_last,
+			mac_tx_error => tx_error,
+			mac_tx_ready => tx_ready
+		);
+
+	-- The MAC holds off one transmit cycle in seven
+	process(mac_clk)
+		variable n: natural range 0 to 6 := 0;
+	begin
+		if rising_edge(mac_clk) then
+			n := (n + 1) mod 7;
+			if n = 0 then
+				tx_ready <= '0';
+			else
+				tx_ready <= '1';
+			end if;
+		end if;
+	end process;
+
+	stim: process
+
+		variable exp_hist: hist_t := (others => 0);
+		variable exp_n, exp_sum, exp_max, exp_lost, exp_orphan, exp_overflow: natural := 0;
+		variable exp_min: natural := natural'high;
+		variable errors: natural := 0;
+		variable t_start, t_end: time;
+		variable t_req: time_array_t(0 to 2 ** QUEUE_BITS + 1);
+		variable d: std_logic_vector(31 downto 0);
+
+		procedure xact(addr: in natural; write: in boolean; wdata: in std_logic_vector(31 downto 0); rdata: out std_logic_vector(31 downto 0)) is
+		begin
+			wait until rising_edge(ipb_clk);
+			ipbw.ipb_addr <= std_logic_vector(to_unsigned(addr, 32));
+			ipbw.ipb_wdata <= wdata;
+			if write then
+				ipbw.ipb_write <= '1';
+			else
+				ipbw.ipb_write <= '0';
+			end if;
+			ipbw.ipb_strobe <= '1';
+			wait until rising_edge(ipb_clk) and (ipbr.ipb_ack = '1' or ipbr.ipb_err = '1');
+			assert ipbr.ipb_err = '0' report "Bus error at address " & integer'image(addr) severity error;
+			rdata := ipbr.ipb_rdata;
+			ipbw <= IPB_WBUS_NULL;
+		end procedure;
+
+		procedure check(what: in string; got, expected: in std_logic_vector(31 downto 0)) is
+		begin
+			if got /= expected then
+				report what & ": read " & integer'image(to_integer(unsigned(got(30 downto 0)))) & " ( bit 31 " & std_logic'image(got(31)) &
+					" ), expected " & integer'image(to_integer(unsigned(expected(30 downto 0)))) severity error;
+				errors := errors + 1;
+			end if;
+		end procedure;
+
+		procedure check_n(what: in string; addr, expected: in natural) is
+		begin
+			xact(addr, false, (others => '0'), d);
+			check(what, d, std_logic_vector(to_unsigned(expected, 32)));
+		end procedure;
+
+		procedure send_rx(f: in frame_t; t: out time) is
+		begin
+			for i in 0 to FRAME_LEN - 1 loop
+				rx_data <= f(i);
+				rx_valid <= '1';
+				if i = FRAME_LEN - 1 then
+					rx_last <= '1';
+				end if;
+				wait until rising_edge(mac_clk);
+				if i = 0 then
+					t := now;
+				end if;
+			end loop;
+			rx_valid <= '0';
+			rx_last <= '0';
+			wait until rising_edge(mac_clk);
+		end procedure;
+
+		-- t is when the last byte went, the ready cycles are those of the process above
+		procedure send_tx(f: in frame_t; t: out time) is
+		begin
+			for i in 0 to FRAME_LEN - 1 loop
+				tx_data <= f(i);
+				tx_valid <= '1';
+				if i = FRAME_LEN - 1 then
+					tx_last <= '1';
+				end if;
+				loop
+					wait until rising_edge(mac_clk);
+					exit when tx_ready = '1';
+				end loop;
+			end loop;
+			t := now;
+			tx_valid <= '0';
+			tx_last <= '0';
+			for i in 1 to 12 loop -- inter-frame gap
+				wait until rising_edge(mac_clk);
+			end loop;
+		end procedure;
+
+		procedure idle(cycles: in natural) is
+		begin
+			for i in 1 to cycles loop
+				wait until rising_edge(mac_clk);
+			end loop;
+		end procedure;
+
+		procedure expect(t0, t1: in time) is
+			variable lat: natural;
+		begin
+			lat := (t1 - t0) / MAC_PERIOD;
+			exp_n := exp_n + 1;
+			exp_sum := exp_sum + lat;
+			if lat < exp_min then
+				exp_min := lat;
+			end if;
+			if lat > exp_max then
+				exp_max := lat;
+			end if;
+			if lat / 2 ** BIN_SHIFT >= N_BINS then
+				exp_hist(N_BINS - 1) := exp_hist(N_BINS - 1) + 1;
+			else
+				exp_hist(lat / 2 ** BIN_SHIFT) := exp_hist(lat / 2 ** BIN_SHIFT) + 1;
+			end if;
+		end procedure;
+
+		procedure pair(id, gap: in natural) is
+		begin
+			send_rx(request(id), t_start);
+			idle(gap);
+			send_tx(response(id), t_end);
+			expect(t_start, t_end);
+		end procedure;
+
+		procedure wait_clear is
+		begin
+			loop
+				xact(A_STAT + 8, false, (others => '0'), d);
+				exit when d(31) = '0';
+			end loop;
+		end procedure;
+
+		procedure check_all is
+		begin
+			wait for 1 us; -- the last match, then into the ipbus clock domain
+			xact(A_CTRL, true, x"00000001", d); -- freeze
+			check_n("Count", A_STAT + 0, exp_n);
+			check_n("Sum", A_STAT + 1, exp_sum);
+			check_n("Sum high word", A_STAT + 2, 0);
+			if exp_n = 0 then
+				xact(A_STAT + 3, false, (others => '0'), d);
+				check("Min", d, x"ffffffff");
+			else
+				check_n("Min", A_STAT + 3, exp_min);
+			end if;
+			check_n("Max", A_STAT + 4, exp_max);
+			check_n("Unanswered", A_STAT + 5, exp_lost);
+			check_n("Orphans", A_STAT + 6, exp_orphan);
+			check_n("Overflow", A_STAT + 7, exp_overflow);
+			for i in 0 to N_BINS - 1 loop
+				check_n("Bin " & integer'image(i), A_HIST + i, exp_hist(i));
+			end loop;
+			xact(A_CTRL, true, x"00000000", d);
+		end procedure;
+
+	begin
+		wait until ipb_rst = '0';
+		wait_clear; -- the histogram is cleared after rst_macclk
+		xact(A_STAT + 8, false, (others => '0'), d);
+		check("Config", d, x"00" & std_logic_vector(to_unsigned(QUEUE_BITS, 8)) &
+			std_logic_vector(to_unsigned(HIST_BITS, 8)) & std_logic_vector(to_unsigned(BIN_SHIFT, 8)));
+
+		-- One request at a time, over the whole histogram
+		pair(1, 0);
+		pair(2, 10);
+		pair(3, 100);
+		pair(4, 300);
+		pair(5, 1000);
+		pair(6, 5000);
+		pair(7, 20000); -- last bin
+
+		-- Ignored: ARP, a request to another MAC address, status packets both ways
+		send_rx(frame(x"ffffffffffff", x"0806", HOST_PORT, IPBUS_PORT, 8, 0), t_start);
+		send_rx(frame(HOST_MAC, x"0800", HOST_PORT, IPBUS_PORT, 9, 0), t_start);
+		send_rx(frame(MAC, x"0800", HOST_PORT, IPBUS_PORT, 0, 1), t_start);
+		idle(50);
+		send_tx(frame(HOST_MAC, x"0800", IPBUS_PORT, HOST_PORT, 0, 1), t_end);
+
+		-- A response with no request ( resend of the last one )
+		send_tx(response(7), t_end);
+		exp_orphan := exp_orphan + 1;
+
+		-- A request never answered, then one that is
+		send_rx(request(100), t_start);
+		idle(200);
+		pair(101, 50);
+		exp_lost := exp_lost + 1;
+
+		-- More requests in flight than the queue holds: the last two are not timed, so their
+		-- responses have no request
+		for i in 0 to 2 ** QUEUE_BITS + 1 loop
+			send_rx(request(200 + i), t_req(i));
+		end loop;
+		idle(100);
+		for i in 0 to 2 ** QUEUE_BITS + 1 loop
+			send_tx(response(200 + i), t_end);
+			if i < 2 ** QUEUE_BITS then
+				expect(t_req(i), t_end);
+			end if;
+		end loop;
+		exp_overflow := exp_overflow + 2;
+		exp_orphan := exp_orphan + 2;
+
+		check_all;
+		report "Latency histogram: " & integer'image(exp_n) & " packets, min " & integer'image(exp_min) &
+			", max " & integer'image(exp_max) & " cycles" severity note;
+
+		-- Nothing is recorded while frozen
+		xact(A_CTRL, true, x"00000001", d);
+		send_rx(request(300), t_start);
+		send_tx(response(300), t_end);
+		wait for 1 us;
+		check_n("Count while frozen", A_STAT + 0, exp_n);
+		xact(A_CTRL, true, x"00000000", d);
+
+		-- Clear, then record one packet with clear still set
+		xact(A_CTRL, true, x"00000002", d);
+		wait_clear;
+		exp_hist := (others => 0);
+		exp_n := 0;
+		exp_sum := 0;
+		exp_min := natural'high;
+		exp_max := 0;
+		exp_lost := 0;
+		exp_orphan := 0;
+		exp_overflow := 0;
+		pair(400, 10);
+		wait for 1 us;
+
+		-- Freeze as a masked write would, rewriting clear as 1: no second clear
+		xact(A_CTRL, true, x"00000003", d);
+		wait for 1 us;
+		xact(A_STAT + 8, false, (others => '0'), d);
+		if d(31) = '1' then
+			report "Clear started again by a write that left it set" severity error;
+			errors := errors + 1;
+		end if;
+		check_n("Count after a write that left clear set", A_STAT + 0, exp_n);
+		xact(A_CTRL, true, x"00000000", d);
+		check_all;
+
+		if errors = 0 then
+			report "Latency histogram test passed" severity note;
+		else
+			report "Latency histogram test failed: " & integer'image(errors) & " errors" severity error;
+		end if;
+		stop <= true;
+		wait;
+	end process;
+
+end tb;
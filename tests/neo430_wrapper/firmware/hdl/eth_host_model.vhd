@@ -0,0 +1,249 @@
+---------------------------------------------------------------------------------
+--
+--   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+--
+--   Licensed under the Apache License, Version 2.0 (the "License");
+--   you may not use this file except in compliance with the License.
+--   You may obtain a copy of the License at
+--
+--       http://www.apache.org/licenses/LICENSE-2.0
+--
+--   Unless required by applicable law or agreed to in writing, software
+--   distributed under the License is distributed on an "AS IS" BASIS,
+--   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--   See the License for the specific language governing permissions and
+--   limitations under the License.
+--
+--                                     - - -
+--
+--   Additional information about ipbus-firmare and the list of ipbus-firmware
+--   contacts are available at
+--
+--       https://ipbus.web.cern.ch/ipbus
+--
+---------------------------------------------------------------------------------
+
+
+
+-- eth_host_model
+--
+-- Behavioural (simulation only) model of the network seen by ipbus_ctrl: an
+-- IPbus host and a RARP server, on the MAC side of ipbus_ctrl ( mac_clk ).
+--
+-- The RARP server answers each RARP request from the board with BOARD_IP,
+-- RARP_DELAY_US later, as scripted by RARP_PATTERN: one character per request,
+-- 'R' to reply and 'D' to drop it ( lost on the way ), the last character
+-- repeating for the requests after. e.g. "DDR": the first two requests are
+-- lost, all later ones answered.
+--
+-- The host sends an IPbus control packet ( packet ID 0, a single word read of
+-- address 0 ) to BOARD_IP every HOST_RETRY_US, as a client retrying after a
+-- timeout would, until the first valid reply; t_reply is when its last byte
+-- left ipbus_ctrl. The board MAC address is taken as known ( a static ARP
+-- entry ), so no ARP is done.
+--
+-- Frames carry no preamble or FCS, as on the MAC interface of ipbus_ctrl.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+entity eth_host_model is
+	generic(
+		BOARD_IP: std_logic_vector(31 downto 0) := x"c0a8c802";
+		HOST_IP: std_logic_vector(31 downto 0) := x"c0a8c801";
+		HOST_MAC: std_logic_vector(47 downto 0) := x"020ddba11500";
+		HOST_PORT: natural := 60001;
+		RARP_DELAY_US: natural := 100;
+		RARP_PATTERN: string := "R";
+		HOST_RETRY_US: positive := 50;
+		READ_DATA: std_logic_vector(31 downto 0) := x"5ca1ab1e" -- what the read must return
+	);
+	port(
+		mac_clk: in std_logic;
+		board_mac: in std_logic_vector(47 downto 0);
+		rx_data: out std_logic_vector(7 downto 0) := (others => '0'); -- to ipbus_ctrl
+		rx_valid: out std_logic := '0';
+		rx_last: out std_logic := '0';
+		rx_error: out std_logic := '0';
+		tx_data: in std_logic_vector(7 downto 0); -- from ipbus_ctrl
+		tx_valid: in std_logic;
+		tx_last: in std_logic;
+		tx_error: in std_logic;
+		tx_ready: out std_logic := '1';
+		t_reply: out time := 0 ns; -- first valid IPbus reply, 0 ns until then
+		n_requests: out natural := 0; -- IPbus requests sent
+		n_rarp_requests: out natural := 0; -- RARP requests from the board
+		n_rarp_replies: out natural := 0 -- RARP replies sent
+	);
+
+end eth_host_model;
+
+architecture behavioural of eth_host_model is
+
+	constant IPBUS_PORT: natural := 50001;
+	constant MIN_FRAME: positive := 60;
+	constant MAX_FRAME: positive := 128; -- longer frames are cut short: none are expected
+	constant IFG: positive := 12; -- inter-frame gap
+
+	type frame_t is array(0 to MAX_FRAME - 1) of std_logic_vector(7 downto 0);
+	type due_t is array(0 to 15) of time;
+
+	signal rarp_seen: natural := 0; -- RARP requests received so far
+	signal rarp_mac: std_logic_vector(47 downto 0); -- target hardware address of the last one
+	signal t_reply_i: time := 0 ns;
+
+	procedure put(f: inout frame_t; pos: natural; v: std_logic_vector) is
+		constant n: natural := v'length / 8;
+		variable x: std_logic_vector(v'length - 1 downto 0) := v;
+	begin
+		for i in 0 to n - 1 loop
+			f(pos + i) := x(8 * (n - i) - 1 downto 8 * (n - i - 1));
+		end loop;
+	end procedure;
+
+	function get(f: frame_t; pos, n: natural) return std_logic_vector is
+		variable x: std_logic_vector(8 * n - 1 downto 0);
+	begin
+		for i in 0 to n - 1 loop
+			x(8 * (n - i) - 1 downto 8 * (n - i - 1)) := f(pos + i);
+		end loop;
+		return x;
+	end function;
+
+	function u16(n: natural) return std_logic_vector is
+	begin
+		return std_logic_vector(to_unsigned(n, 16));
+	end function;
+
+	-- IPbus read of address 0 to BOARD_IP, in Ethernet / IPv4 / UDP
+	function request(dst: std_logic_vector(47 downto 0)) return frame_t is
+		variable f: frame_t := (others => x"00");
+		variable sum: unsigned(19 downto 0) := (others => '0');
+	begin
+		put(f, 0, dst);
+		put(f, 6, HOST_MAC);
+		put(f, 12, x"0800");
+		put(f, 14, x"4500" & u16(20 + 8 + 12) & x"00004000" & x"4011" & x"0000" & HOST_IP & BOARD_IP);
+		for i in 0 to 9 loop
+			sum := sum + unsigned(get(f, 14 + 2 * i, 2));
+		end loop;
+		sum := resize(sum(15 downto 0), 20) + sum(19 downto 16);
+		sum := resize(sum(15 downto 0), 20) + sum(19 downto 16);
+		put(f, 24, not std_logic_vector(sum(15 downto 0))); -- header checksum
+		put(f, 34, u16(HOST_PORT) & u16(IPBUS_PORT) & u16(8 + 12) & x"0000");
+		put(f, 42, x"200000f0" & x"2000010f" & x"00000000");
+		return f;
+	end function;
+
+	function rarp_reply(dst: std_logic_vector(47 downto 0)) return frame_t is
+		variable f: frame_t := (others => x"00");
+	begin
+		put(f, 0, dst);
+		put(f, 6, HOST_MAC);
+		put(f, 12, x"8035");
+		put(f, 14, x"0001" & x"0800" & x"06" & x"04" & x"0004");
+		put(f, 22, HOST_MAC & HOST_IP & dst & BOARD_IP);
+		return f;
+	end function;
+
+	function pattern(n: positive) return character is
+	begin
+		if n > RARP_PATTERN'length then
+			return RARP_PATTERN(RARP_PATTERN'right);
+		end if;
+		return RARP_PATTERN(RARP_PATTERN'left + n - 1);
+	end function;
+
+begin
+
+	tx_ready <= '1';
+	t_reply <= t_reply_i;
+
+-- Frames from the board
+
+	tx: process
+		variable f: frame_t;
+		variable pos: natural;
+	begin
+		pos := 0;
+		loop
+			wait until rising_edge(mac_clk);
+			if tx_valid = '1' then
+				if pos < MAX_FRAME then
+					f(pos) := tx_data;
+					pos := pos + 1;
+				end if;
+				exit when tx_last = '1';
+			end if;
+		end loop;
+
+		if tx_error = '1' or pos < MIN_FRAME then
+			report "eth_host_model: bad frame from the board" severity error;
+		elsif get(f, 12, 2) = x"8035" and get(f, 20, 2) = x"0003" then
+			rarp_mac <= get(f, 32, 6);
+			rarp_seen <= rarp_seen + 1;
+		elsif get(f, 12, 2) = x"0800" and get(f, 23, 1) = x"11" and get(f, 34, 4) = u16(IPBUS_PORT) & u16(HOST_PORT) then
+			if get(f, 26, 4) /= BOARD_IP then
+				report "eth_host_model: IPbus reply from the wrong IP address" severity error;
+			elsif get(f, 42, 12) /= x"200000f0" & x"20000100" & READ_DATA then
+				report "eth_host_model: unexpected IPbus reply" severity error;
+			elsif t_reply_i = 0 ns then
+				t_reply_i <= now;
+			end if;
+		end if;
+	end process;
+
+	n_rarp_requests <= rarp_seen;
+
+-- Frames to the board: RARP replies when they are due, otherwise IPbus requests until one is answered
+
+	rx: process
+		variable due: due_t;
+		variable n_due, handled, n_req, n_rarp: natural := 0;
+		variable next_req: time := 0 ns;
+
+		procedure send(f: frame_t) is
+		begin
+			for i in 0 to MIN_FRAME - 1 loop
+				rx_data <= f(i);
+				rx_valid <= '1';
+				if i = MIN_FRAME - 1 then
+					rx_last <= '1';
+				end if;
+				wait until rising_edge(mac_clk);
+			end loop;
+			rx_valid <= '0';
+			rx_last <= '0';
+			for i in 1 to IFG loop
+				wait until rising_edge(mac_clk);
+			end loop;
+		end procedure;
+
+	begin
+		wait until rising_edge(mac_clk);
+		if rarp_seen /= handled then
+			handled := handled + 1;
+			if pattern(handled) = 'D' then
+				report "eth_host_model: RARP request " & integer'image(handled) & " dropped" severity note;
+			elsif n_due <= due'high then
+				due(n_due) := now + RARP_DELAY_US * 1 us;
+				n_due := n_due + 1;
+			end if;
+		end if;
+
+		if n_due > 0 and now >= due(0) then
+			send(rarp_reply(rarp_mac));
+			n_rarp := n_rarp + 1;
+			n_rarp_replies <= n_rarp;
+			due(0 to due'high - 1) := due(1 to due'high);
+			n_due := n_due - 1;
+		elsif t_reply_i = 0 ns and now >= next_req then
+			send(request(board_mac));
+			n_req := n_req + 1;
+			n_requests <= n_req;
+			next_req := now + HOST_RETRY_US * 1 us;
+		end if;
+	end process;
+
+end behavioural;
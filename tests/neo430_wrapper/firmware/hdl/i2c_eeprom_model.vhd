@@ -0,0 +1,168 @@
+---------------------------------------------------------------------------------
+--
+--   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+--
+--   Licensed under the Apache License, Version 2.0 (the "License");
+--   you may not use this file except in compliance with the License.
+--   You may obtain a copy of the License at
+--
+--       http://www.apache.org/licenses/LICENSE-2.0
+--
+--   Unless required by applicable law or agreed to in writing, software
+--   distributed under the License is distributed on an "AS IS" BASIS,
+--   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--   See the License for the specific language governing permissions and
+--   limitations under the License.
+--
+--                                     - - -
+--
+--   Additional information about ipbus-firmare and the list of ipbus-firmware
+--   contacts are available at
+--
+--       https://ipbus.web.cern.ch/ipbus
+--
+---------------------------------------------------------------------------------
+
+
+-- i2c_eeprom_model
+--
+-- Behavioural (simulation only) model of a Microchip 24AA025E I2C EEPROM:
+-- 256 bytes, one address byte, sequential reads and 16-byte page writes. The
+-- EUI-48 unique ID is preloaded at 0xFA - 0xFF and the IP address at 0x00.
+-- Writes complete immediately ( no write cycle time ).
+--
+-- sda_o follows the I2C core pad convention: '0' pulls the line low, '1'
+-- releases it. The bus itself ( wired-AND with pull-up ) lives in the testbench.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+entity i2c_eeprom_model is
+	generic(
+		I2C_ADDR: std_logic_vector(7 downto 0) := x"50";
+		IP_ADDR: std_logic_vector(31 downto 0) := x"c0a8c802"; -- 192.168.200.2
+		UID: std_logic_vector(47 downto 0) := x"0004a3123456"
+	);
+	port(
+		scl_i: in std_logic;
+		sda_i: in std_logic;
+		sda_o: out std_logic := '1'
+	);
+
+end i2c_eeprom_model;
+
+architecture behavioural of i2c_eeprom_model is
+
+	type mem_t is array(0 to 255) of std_logic_vector(7 downto 0);
+	type state_t is (IDLE, DEV, DEV_ACK, WADDR, WADDR_ACK, WDATA, WDATA_ACK, RDATA, RDATA_ACK);
+
+	function init_mem return mem_t is
+		variable m: mem_t := (others => x"ff");
+	begin
+		for i in 0 to 3 loop
+			m(i) := IP_ADDR(31 - 8 * i downto 24 - 8 * i);
+		end loop;
+		for i in 0 to 5 loop
+			m(16#fa# + i) := UID(47 - 8 * i downto 40 - 8 * i);
+		end loop;
+		return m;
+	end function;
+
+begin
+
+	process(scl_i, sda_i)
+		variable mem: mem_t := init_mem;
+		variable state: state_t := IDLE;
+		variable sr: std_logic_vector(7 downto 0);
+		variable nbit: natural range 0 to 8;
+		variable ptr: natural range 0 to 255 := 0;
+		variable rw, mack: std_logic;
+	begin
+		if sda_i'event and to_x01(scl_i) = '1' then
+			-- START ( or repeated START ) / STOP
+			if to_x01(sda_i) = '0' then
+				state := DEV;
+				nbit := 0;
+			else
+				state := IDLE;
+			end if;
+			sda_o <= '1';
+
+		elsif scl_i'event and to_x01(scl_i) = '1' then
+			-- sample on rising SCL
+			case state is
+				when DEV | WADDR | WDATA =>
+					sr := sr(6 downto 0) & to_x01(sda_i);
+					nbit := nbit + 1;
+				when RDATA_ACK =>
+					mack := to_x01(sda_i);
+				when others =>
+					null;
+			end case;
+
+		elsif scl_i'event and to_x01(scl_i) = '0' then
+			-- drive on falling SCL
+			case state is
+				when DEV =>
+					if nbit = 8 then
+						if sr(7 downto 1) = I2C_ADDR(6 downto 0) then
+							rw := sr(0);
+							sda_o <= '0';
+							state := DEV_ACK;
+						else
+							state := IDLE;
+						end if;
+					end if;
+				when DEV_ACK =>
+					nbit := 0;
+					if rw = '1' then
+						sr := mem(ptr);
+						sda_o <= sr(7);
+						state := RDATA;
+					else
+						sda_o <= '1';
+						state := WADDR;
+					end if;
+				when WADDR =>
+					if nbit = 8 then
+						ptr := to_integer(unsigned(sr));
+						sda_o <= '0';
+						state := WADDR_ACK;
+					end if;
+				when WADDR_ACK | WDATA_ACK =>
+					nbit := 0;
+					sda_o <= '1';
+					state := WDATA;
+				when WDATA =>
+					if nbit = 8 then
+						mem(ptr) := sr;
+						ptr := (ptr / 16) * 16 + (ptr + 1) mod 16; -- wrap within the page
+						sda_o <= '0';
+						state := WDATA_ACK;
+					end if;
+				when RDATA =>
+					nbit := nbit + 1;
+					if nbit = 8 then
+						sda_o <= '1';
+						state := RDATA_ACK;
+					else
+						sda_o <= sr(7 - nbit);
+					end if;
+				when RDATA_ACK =>
+					ptr := (ptr + 1) mod 256;
+					if mack = '0' then
+						nbit := 0;
+						sr := mem(ptr);
+						sda_o <= sr(7);
+						state := RDATA;
+					else
+						state := IDLE;
+					end if;
+				when IDLE =>
+					sda_o <= '1';
+			end case;
+		end if;
+	end process;
+
+end behavioural;
@@ -0,0 +1,278 @@
+---------------------------------------------------------------------------------
+--
+--   Copyright 2017 - Rutherford Appleton Laboratory and University of Bristol
+--
+--   Licensed under the Apache License, Version 2.0 (the "License");
+--   you may not use this file except in compliance with the License.
+--   You may obtain a copy of the License at
+--
+--       http://www.apache.org/licenses/LICENSE-2.0
+--
+--   Unless required by applicable law or agreed to in writing, software
+--   distributed under the License is distributed on an "AS IS" BASIS,
+--   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+--   See the License for the specific language governing permissions and
+--   limitations under the License.
+--
+--                                     - - -
+--
+--   Additional information about ipbus-firmare and the list of ipbus-firmware
+--   contacts are available at
+--
+--       https://ipbus.web.cern.ch/ipbus
+--
+---------------------------------------------------------------------------------
+
+
+-- ipbus_neo430_wrapper_tb
+--
+-- Boots the NEO430 soft core ( with the application image built from
+-- software/neo430_ipbus_address_terminal ) against a model of the 24AA025E
+-- EEPROM, checks the addresses it programs and
+-- reports when each of them was set and when the IPBus reset was released.
+--
+-- The addresses cross to their own 125MHz clock and the IPBus reset to the
+-- IPBus clock ( CDC_OUTPUTS, as in te0712_infra ), so the CPU clock can be
+-- anything: run with CLOCK_SPEED 125000000 as well as the default 31.25MHz
+-- and compare the "Boot to link" times.
+--
+-- With IPBUS_LINK the addresses drive an ipbus_ctrl, on the network of
+-- eth_host_model: a host polling the board with IPbus reads, and a RARP server
+-- with a scripted delay and losses ( RARP_DELAY_US, RARP_PATTERN ). The time
+-- from the IPBus reset release to the first IPbus reply is reported ( "Link to
+-- first reply" ). With PROM_RARP the PROM holds IP address 0.0.0.0, so the
+-- board has to get its address by RARP first.
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+use work.ipbus.all;
+
+entity top is
+	generic(
+		CLOCK_SPEED: natural := 31250000;
+		CDC_OUTPUTS: boolean := true;
+		UID_I2C_ADDR: std_logic_vector(7 downto 0) := x"50";
+		PROM_RARP: boolean := false; -- PROM IP address 0.0.0.0: use RARP
+		PROM_IP_ADDR: std_logic_vector(31 downto 0) := x"c0a8c802"; -- 192.168.200.2
+		PROM_UID: std_logic_vector(47 downto 0) := x"0004a3123456";
+		TIMEOUT: time := 1 sec;
+		IPBUS_LINK: boolean := false;
+		RARP_DELAY_US: natural := 100; -- RARP server response time
+		RARP_PATTERN: string := "R"; -- per RARP request: R reply, D drop ( see eth_host_model )
+		HOST_RETRY_US: positive := 50; -- IPbus host retry interval
+		LINK_TIMEOUT: time := 2 sec -- from the end of the boot to the first IPbus reply
+	);
+end top;
+
+architecture tb of top is
+
+	constant CLK_PERIOD: time := 1 sec / CLOCK_SPEED;
+	constant IPB_CLK_PERIOD: time := 30 ns; -- not a multiple of CLK_PERIOD at either CPU clock
+	constant MAC_CLK_PERIOD: time := 8 ns; -- clk125
+
+	function prom_ip return std_logic_vector is
+	begin
+		if PROM_RARP then
+			return x"00000000";
+		end if;
+		return PROM_IP_ADDR;
+	end function;
+
+	constant PROM_IP: std_logic_vector(31 downto 0) := prom_ip;
+	constant RARP_IP_ADDR: std_logic_vector(31 downto 0) := x"c0a8c863"; -- 192.168.200.99, from the RARP server
+	constant LINK_READ_DATA: std_logic_vector(31 downto 0) := x"5ca1ab1e";
+
+	-- where the host finds the board
+	function link_ip return std_logic_vector is
+	begin
+		if PROM_RARP then
+			return RARP_IP_ADDR;
+		end if;
+		return PROM_IP_ADDR;
+	end function;
+
+	signal clk: std_logic := '0';
+	signal ipb_clk: std_logic := '0';
+	signal mac_clk: std_logic := '0';
+	signal rst: std_logic := '1';
+	signal stop: boolean := false;
+	signal scl, sda, scl_m, sda_m, sda_s: std_logic;
+	signal use_rarp, ipbus_rst: std_logic;
+	signal ip_addr: std_logic_vector(31 downto 0);
+	signal mac_addr: std_logic_vector(47 downto 0);
+	signal eth_rx_data, eth_tx_data: std_logic_vector(7 downto 0);
+	signal eth_rx_valid, eth_rx_last, eth_rx_error, eth_tx_valid, eth_tx_last, eth_tx_error, eth_tx_ready: std_logic;
+	signal link_rst_sync: std_logic_vector(1 downto 0) := "11";
+	signal link_ipb_w: ipb_wbus;
+	signal link_ipb_r: ipb_rbus := IPB_RBUS_NULL;
+	signal t_reply: time := 0 ns;
+	signal n_link_requests, n_rarp_requests, n_rarp_replies: natural := 0;
+
+begin
+
+	clk <= not clk after CLK_PERIOD / 2 when not stop;
+	ipb_clk <= not ipb_clk after IPB_CLK_PERIOD / 2 when not stop;
+	mac_clk <= not mac_clk after MAC_CLK_PERIOD / 2 when not stop;
+	rst <= '0' after 20 * CLK_PERIOD;
+
+	dut: entity work.ipbus_neo430_wrapper
+		generic map(
+			CLOCK_SPEED => CLOCK_SPEED,
+			UID_I2C_ADDR => UID_I2C_ADDR,
+			CDC_OUTPUTS => CDC_OUTPUTS
+		)
+		port map(
+			clk_i => clk,
+			rst_i => rst,
+			uart_txd_o => open,
+			uart_rxd_i => '1',
+			leds => open,
+			scl_o => scl_m,
+			scl_i => scl,
+			sda_o => sda_m,
+			sda_i => sda,
+			gp_o => open,
+			use_rarp_o => use_rarp,
+			ip_addr_o => ip_addr,
+			mac_addr_o => mac_addr,
+			ipbus_rst_o => ipbus_rst,
+			mac_clk_i => mac_clk,
+			ipb_clk => ipb_clk
+		);
+
+	prom: entity work.i2c_eeprom_model
+		generic map(
+			I2C_ADDR => UID_I2C_ADDR,
+			IP_ADDR => PROM_IP,
+			UID => PROM_UID
+		)
+		port map(
+			scl_i => scl,
+			sda_i => sda,
+			sda_o => sda_s
+		);
+
+-- IPBus core on the addresses from the soft core, and the network it is on. Its reset is the
+-- soft core's, as in te0712_infra
+	gen_link: if IPBUS_LINK generate
+
+		process(mac_clk)
+		begin
+			if rising_edge(mac_clk) then
+				link_rst_sync <= link_rst_sync(0) & ipbus_rst;
+			end if;
+		end process;
+
+		ipbus: entity work.ipbus_ctrl
+			port map(
+				mac_clk => mac_clk,
+				rst_macclk => link_rst_sync(1),
+				ipb_clk => ipb_clk,
+				rst_ipb => ipbus_rst,
+				mac_rx_data => eth_rx_data,
+				mac_rx_valid => eth_rx_valid,
+				mac_rx_last => eth_rx_last,
+				mac_rx_error => eth_rx_error,
+				mac_tx_data => eth_tx_data,
+				mac_tx_valid => eth_tx_valid,
+				mac_tx_last => eth_tx_last,
+				mac_tx_error => eth_tx_error,
+				mac_tx_ready => eth_tx_ready,
+				ipb_out => link_ipb_w,
+				ipb_in => link_ipb_r,
+				RARP_select => use_rarp,
+				mac_addr => mac_addr,
+				ip_addr => ip_addr,
+				pkt => open
+			);
+
+		-- a single register for the host to read
+		process(ipb_clk)
+		begin
+			if rising_edge(ipb_clk) then
+				link_ipb_r.ipb_ack <= link_ipb_w.ipb_strobe and not link_ipb_r.ipb_ack;
+			end if;
+		end process;
+
+		link_ipb_r.ipb_rdata <= LINK_READ_DATA;
+		link_ipb_r.ipb_err <= '0';
+
+		host: entity work.eth_host_model
+			generic map(
+				BOARD_IP => link_ip,
+				RARP_DELAY_US => RARP_DELAY_US,
+				RARP_PATTERN => RARP_PATTERN,
+				HOST_RETRY_US => HOST_RETRY_US,
+				READ_DATA => LINK_READ_DATA
+			)
+			port map(
+				mac_clk => mac_clk,
+				board_mac => mac_addr,
+				rx_data => eth_rx_data,
+				rx_valid => eth_rx_valid,
+				rx_last => eth_rx_last,
+				rx_error => eth_rx_error,
+				tx_data => eth_tx_data,
+				tx_valid => eth_tx_valid,
+				tx_last => eth_tx_last,
+				tx_error => eth_tx_error,
+				tx_ready => eth_tx_ready,
+				t_reply => t_reply,
+				n_requests => n_link_requests,
+				n_rarp_requests => n_rarp_requests,
+				n_rarp_replies => n_rarp_replies
+			);
+
+	end generate;
+
+-- Open-drain bus with pull-ups
+	scl <= '0' when scl_m = '0' else '1';
+	sda <= '0' when sda_m = '0' or sda_s = '0' else '1';
+
+	monitor: process
+		variable t_mac, t_ip, t_rst: time := 0 ns;
+	begin
+		wait until rst = '0';
+		loop
+			wait on mac_addr, ip_addr, ipbus_rst for TIMEOUT;
+			if mac_addr'event then t_mac := now; end if;
+			if ip_addr'event then t_ip := now; end if;
+			exit when ipbus_rst'event and ipbus_rst = '0';
+			assert now < TIMEOUT report "Timeout waiting for the IPBus reset to be released" severity failure;
+		end loop;
+		t_rst := now;
+
+		report "MAC set at " & time'image(t_mac) & ", IP at " & time'image(t_ip) severity note;
+		report "IPBus reset released at " & time'image(t_rst) severity note;
+		report "Boot to link: " & time'image(t_rst - 20 * CLK_PERIOD) & " with the CPU at " & integer'image(CLOCK_SPEED / 1000) & " kHz" severity note;
+
+		assert mac_addr = PROM_UID
+			report "MAC address does not match the PROM UID" severity error;
+		if PROM_RARP then
+			assert use_rarp = '1'
+				report "RARP not selected with IP address 0.0.0.0 in the PROM" severity error;
+		else
+			assert ip_addr = PROM_IP_ADDR and use_rarp = '0'
+				report "IP address does not match the PROM" severity error;
+		end if;
+
+		if IPBUS_LINK then
+			if t_reply = 0 ns then
+				wait until t_reply /= 0 ns for LINK_TIMEOUT;
+			end if;
+			assert t_reply /= 0 ns
+				report "No IPbus reply within " & time'image(LINK_TIMEOUT) & " of the end of the boot" severity failure;
+			report "Link to first reply: " & time'image(t_reply - t_rst) & " ( RARP " & boolean'image(use_rarp = '1') &
+				", " & integer'image(n_rarp_requests) & " RARP requests, " & integer'image(n_rarp_replies) & " replies after " &
+				integer'image(RARP_DELAY_US) & " us, pattern " & RARP_PATTERN & ", " & integer'image(n_link_requests) &
+				" IPbus requests every " & integer'image(HOST_RETRY_US) & " us )" severity note;
+			report "Power-up to first reply: " & time'image(t_reply) severity note;
+		end if;
+
+		stop <= true;
+		wait;
+	end process;
+
+end tb;
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+Compare the times reported by the boot scenarios of test-run-sim-neo430.sh
+( neo430_boot_times.txt ) against the reference times in boot_times.ref, and
+fail if any is slower than its reference by more than --tolerance.
+
+e.g.
+  python3 check_boot_times.py neo430_boot_times.txt
+  python3 check_boot_times.py neo430_boot_times.txt --update    # record this run as the reference
+
+The reference has one time per line: scenario, quantity, microseconds. A time
+with no reference is listed but does not fail the check.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+REF = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, 'boot_times.ref')
+
+# Reported quantity ( as in the testbench ) : key in the reference
+QUANTITIES = {
+    'Boot to link': 'boot_to_link',
+    'Link to first reply': 'link_to_reply',
+    'Power-up to first reply': 'powerup_to_reply',
+}
+
+UNITS_US = {'fs': 1e-9, 'ps': 1e-6, 'ns': 1e-3, 'us': 1.0, 'ms': 1e3, 'sec': 1e6}
+
+SCENARIO_RE = re.compile(r'^(\w+):')
+TIME_RE = re.compile(r'(%s): (\d+) (%s)\b' % ('|'.join(QUANTITIES), '|'.join(UNITS_US)))
+
+
+def read_summary(fname):
+    """{ ( scenario, key ): microseconds } of a neo430_boot_times.txt."""
+    times = {}
+    scenario = None
+    with open(fname) as f:
+        for line in f:
+            m = SCENARIO_RE.match(line)
+            if m:
+                scenario = m.group(1)
+                continue
+            m = TIME_RE.search(line)
+            if m and scenario:
+                times[(scenario, QUANTITIES[m.group(1)])] = int(m.group(2)) * UNITS_US[m.group(3)]
+    return times
+
+
+def read_ref(fname):
+    ref = {}
+    with open(fname) as f:
+        for line in f:
+            fields = line.split('#')[0].split()
+            if fields:
+                ref[(fields[0], fields[1])] = float(fields[2])
+    return ref
+
+
+def write_ref(fname, times):
+    with open(fname) as f:
+        header = [line for line in f if line.startswith('#') and 'No run has been recorded' not in line]
+    with open(fname, 'w') as f:
+        f.writelines(header)
+        for (scenario, key), t in sorted(times.items()):
+            f.write('%-16s %-18s %.1f\n' % (scenario, key, t))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('summary', help='neo430_boot_times.txt of a run')
+    parser.add_argument('--ref', default=REF, help='reference times ( default: tests/neo430_wrapper/boot_times.ref )')
+    parser.add_argument('--tolerance', type=float, default=0.05, help='allowed slow down, as a fraction ( default 0.05 )')
+    parser.add_argument('--update', action='store_true', help='write the times of this run as the reference')
+    args = parser.parse_args()
+
+    times = read_summary(args.summary)
+    if not times:
+        print('ERROR: no times found in %s' % args.summary)
+        return 1
+    if args.update:
+        write_ref(args.ref, times)
+        print('%d reference times written to %s' % (len(times), args.ref))
+        return 0
+
+    ref = read_ref(args.ref)
+    slower = 0
+    for (scenario, key), t in sorted(times.items()):
+        if (scenario, key) not in ref:
+            print('%-16s %-18s %12.1f us   no reference' % (scenario, key, t))
+            continue
+        r = ref[(scenario, key)]
+        change = (t - r) / r if r else 0.0
+        status = 'ok'
+        if change > args.tolerance:
+            status = 'SLOWER'
+            slower += 1
+        print('%-16s %-18s %12.1f us   reference %12.1f us   %+6.1f %%   %s' % (scenario, key, t, r, 100 * change, status))
+    if slower:
+        print('%d times slower than the reference by more than %.0f %%' % (slower, 100 * args.tolerance))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
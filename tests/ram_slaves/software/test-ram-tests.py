@@ -1,5 +1,6 @@
-#!/usr/bin/env python2
+#!/usr/bin/env python3
 
+import argparse
 import uhal
 import os.path
 import random
@@ -40,17 +41,17 @@ def portedram_writeandreadback(pram_node):
     device.dispatch()
 
     # in_words = [random.randint(0,(1<<32-1)) for _ in xrange(pram_node.getNode('data').getSize())]
-    in_words = range(pram_node.getNode('data').getSize(), 0, -1)
+    in_words = list(range(pram_node.getNode('data').getSize(), 0, -1))
     writeported(pram_node, in_words)
     device.dispatch()
     val_vec = readported(pram_node)
     device.dispatch()
 
     ok = in_words == list(val_vec)
-    print 'SUCCEDED' if ok else 'FAILED',repr(pram_node.getId()), ': readback test ('+str(pram_node.getNode('data').getSize()),'words)'
+    print('SUCCEDED' if ok else 'FAILED',repr(pram_node.getId()), ': readback test ('+str(pram_node.getNode('data').getSize()),'words)')
 
     if not ok:
-        print '   First mismatch at:', next( (idx, x, y) for idx, (x, y) in enumerate(zip(in_words, val_vec)) if x!=y )
+        print('   First mismatch at:', next( (idx, x, y) for idx, (x, y) in enumerate(zip(in_words, val_vec)) if x!=y ))
 
 # ----------------------------------------------------------
 
@@ -60,24 +61,30 @@ def ram_writeandreadback(ram_node):
     valvec = ram_node.readBlock(ram_node.getSize())
     ram_node.getClient().dispatch()
 
-    in_words = range(ram_node.getSize(), 0, -1)
+    in_words = list(range(ram_node.getSize(), 0, -1))
     ram_node.writeBlock(in_words)
     ram_node.getClient().dispatch()
     val_vec = ram_node.readBlock(ram_node.getSize())
     ram_node.getClient().dispatch()
 
     ok = in_words == list(val_vec)
-    print 'SUCCEDED' if ok else 'FAILED',repr(ram_node.getId()), ': readback test ('+str(ram_node.getSize()),'words)'
+    print('SUCCEDED' if ok else 'FAILED',repr(ram_node.getId()), ': readback test ('+str(ram_node.getSize()),'words)')
 
     if not ok:
-        print '   First mismatch at:', next( (idx, x, y) for idx, (x, y) in enumerate(zip(in_words, val_vec)) if x!=y )
+        print('   First mismatch at:', next( (idx, x, y) for idx, (x, y) in enumerate(zip(in_words, val_vec)) if x!=y ))
 # ----------------------------------------------------------
 
 
-reladdrpath = [os.pardir, os.pardir, 'components', 'ipbus_util', 'addr_table', 'ram_slaves_tester.xml']
+reladdrpath = [os.pardir, 'addr_table', 'ram_slaves_tester.xml']
 addrtabpath = 'file://'+os.path.normpath(os.path.join(os.path.abspath(os.path.dirname(__file__)), *reladdrpath ))
 
-device = uhal.getDevice('SIM', 'ipbusudp-2.0://192.168.201.2:50001', addrtabpath)
+parser = argparse.ArgumentParser()
+parser.add_argument('--client', default='ipbusudp-2.0://192.168.201.2:50001', help='e.g. ipbusudp-2.0://localhost:50001 for a simulation or ipbus_udp_emulator.py')
+parser.add_argument('--addr', default=addrtabpath)
+parser.add_argument('--wait', type=float, default=5, help='seconds to wait for the pattern generator')
+args = parser.parse_args()
+
+device = uhal.getDevice('SIM', args.client, args.addr)
 
 # Reset
 # device.getNode('csr.ctrl.rst').write(0x1)
@@ -88,18 +95,18 @@ csr_stat = device.getNode('csr.stat').read()
 device.dispatch()
 
 
-print 'stat =',hex(csr_stat)
+print('stat =',hex(csr_stat))
 
 # ----- rw reg
 reg_node = device.getNode('reg')
 val = reg_node.read()
 device.dispatch()
-print 'reg B =',hex(val)
+print('reg B =',hex(val))
 
 reg_node.write(5)
 val = reg_node.read()
 device.dispatch()
-print 'reg A =',hex(val)
+print('reg A =',hex(val))
 
 # # ----- peephole ram
 # portedram_writeandreadback(device.getNode('ported_ram'))
@@ -119,7 +126,7 @@ print 'reg A =',hex(val)
 # # ----- duap-port ram (36 bits)
 # ram_writeandreadback(device.getNode('dpram36'))
 
-print '--- Before ---'
+print('--- Before ---')
 # device.getNode('dpram').writeBlock([0]*device.getNode('dpram').getSize())
 # device.dispatch()
 
@@ -134,10 +141,10 @@ device.getNode('patt_gen.ctrl.fire').write(0x1)
 device.getNode('patt_gen.ctrl.fire').write(0x0)
 device.dispatch()
 
-time.sleep(5)
+time.sleep(args.wait)
 # raise SystemExit(0)
 
-print '--- After ---'
+print('--- After ---')
 # valvec = device.getNode('dpram').readBlock(device.getNode('dpram').getSize())
 # device.dispatch()
 # print [ hex(x) for x in valvec]
@@ -166,11 +173,11 @@ print '--- After ---'
 #     ])
 
 
-print '---spdpram 72---'
+print('---spdpram 72---')
 valvec = readported(device.getNode('ported_sdpram72'))
 device.dispatch()
-print '\n'.join([
+print('\n'.join([
      "%02d 0x%08x" % (i,x) for i,x in enumerate(valvec[:32])
-    ])
+    ]))
 
 